@@ -0,0 +1,51 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+/**
+ * Renders the frame into an offscreen framebuffer at a fraction of the window's resolution,
+ * then upscales it to the window with a linear blit.
+ * The fraction follows the GPU time of the frames, measured with GL_TIME_ELAPSED queries: it drops
+ * while frames go over the target time and climbs back once they are comfortably under it, within
+ * the minimum and maximum scales. Queries are read back a few frames late, so timing never stalls.
+ * The framebuffer is allocated at the maximum scale and only its bottom left corner is drawn to,
+ * so scale changes don't reallocate anything.
+**/
+class DynamicResolution {
+public:
+	DynamicResolution();
+
+	// Target time in milliseconds
+	void Create(GLuint width, GLuint height, GLfloat minScale, GLfloat maxScale, GLfloat targetTime);
+	void Resize(GLuint width, GLuint height);
+
+	// Binds the framebuffer and the scaled viewport, and starts timing the frame
+	void Begin();
+
+	// Stops timing, upscales to the default framebuffer and adjusts the scale from the latest timings
+	void End();
+
+	// Size the frame is drawn at, only changed by End
+	GLuint Width();
+	GLuint Height();
+
+	GLfloat Scale();
+
+	// Smoothed GPU time of the frames, in milliseconds
+	GLfloat GPUTime();
+
+private:
+	// Frames a query may take to become available before its slot comes around again
+	static const int QUERIES = 4;
+
+	void Allocate();
+	void Control(GLfloat time);
+
+	GLuint framebuffer, colorBuffer, depthBuffer;
+	GLuint queries[QUERIES];
+	bool pending[QUERIES];
+	int query;
+
+	GLuint width, height, renderWidth, renderHeight;
+	GLfloat scale, minScale, maxScale, targetTime, gpuTime;
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+
+/**
+ * Paces frames to a target frame time, called right after each swap.
+ * Waits sleep until shortly before the frame's deadline, then spin for the rest, as sleeps
+ * are only as precise as the OS scheduler. The spin window grows to the worst oversleep seen
+ * recently, so a coarse timer costs more spinning rather than late frames.
+ * Deadlines advance by exactly one frame time, so late frames don't shift the ones after them,
+ * unless a frame is so late that catching up would rush several frames out.
+ * Intervals between frames are recorded either way, for the pacing statistics.
+**/
+class FrameLimiter {
+public:
+	FrameLimiter();
+
+	// Frame time and shortest spin window in seconds, a frame time of 0 only records intervals
+	void Create(double frameTime, double spinTime);
+
+	// Waits for the frame's deadline, and records the interval since the previous frame
+	void Wait();
+
+	// The next frame starts a new interval, for frames that were not drawn (e.g. skipped while idle)
+	void Restart();
+
+	// Pacing since the last ResetStats, in milliseconds
+	double MeanInterval();
+	double Jitter();
+	double WorstInterval();
+
+	// Frames delivered more than half a frame time after their deadline
+	unsigned int LateFrames();
+
+	void ResetStats();
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	double frameTime, spinTime, oversleep;
+	Clock::time_point deadline, lastFrame;
+	bool started;
+
+	// Interval sums, for the mean and standard deviation
+	unsigned int intervals, lateFrames;
+	double intervalSum, intervalSquareSum, worstInterval;
+};
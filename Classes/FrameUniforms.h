@@ -0,0 +1,32 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+
+/**
+ * Per-frame data shared by every shader program through the std140 "Frame" uniform block,
+ * bound at a fixed binding point. Updated once per frame instead of per program and draw.
+**/
+class FrameUniforms {
+public:
+	// Every program declaring the Frame block gets it bound here (see Shader)
+	static const GLuint BINDING = 0;
+
+	FrameUniforms();
+
+	void Create();
+	void Update(const glm::mat4 &projection, const glm::mat4 &view, GLuint width, GLuint height, GLfloat time, GLfloat deltaTime);
+
+private:
+	// std140 layout of the Frame block
+	struct Block {
+		glm::mat4 projection;
+		glm::mat4 view;
+		// Width, height and their reciprocals
+		glm::vec4 viewport;
+		GLfloat time, deltaTime;
+		GLfloat padding[2];
+	};
+
+	GLuint UBO;
+};
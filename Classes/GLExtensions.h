@@ -0,0 +1,79 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+/**
+ * The GLAD loader in Source/GLAD.c was generated for OpenGL 3.3 core.
+ * Entry points and tokens from newer versions, used by the optional rendering paths,
+ * are declared and loaded here in the same fashion. Each path must check the
+ * matching flag before using them, as they stay null on older contexts.
+**/
+
+#ifndef GL_VERSION_4_0
+typedef void (APIENTRYP PFNGLDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void *indirect);
+extern PFNGLDRAWELEMENTSINDIRECTPROC glad_glDrawElementsIndirect;
+#define glDrawElementsIndirect glad_glDrawElementsIndirect
+#endif
+
+#ifndef GL_VERSION_4_2
+typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+extern PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier;
+#define glMemoryBarrier glad_glMemoryBarrier
+#endif
+
+#ifndef GL_VERSION_4_3
+typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+extern PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute;
+#define glDispatchCompute glad_glDispatchCompute
+#endif
+
+#ifndef GL_VERSION_4_4
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+#endif
+
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_COMMAND_BARRIER_BIT
+#define GL_COMMAND_BARRIER_BIT 0x00000040
+#endif
+#ifndef GL_BUFFER_UPDATE_BARRIER_BIT
+#define GL_BUFFER_UPDATE_BARRIER_BIT 0x00000200
+#endif
+#ifndef GL_SHADER_STORAGE_BARRIER_BIT
+#define GL_SHADER_STORAGE_BARRIER_BIT 0x00002000
+#endif
+#ifndef GL_COMPUTE_SHADER
+#define GL_COMPUTE_SHADER 0x91B9
+#endif
+#ifndef GL_SHADER_STORAGE_BUFFER
+#define GL_SHADER_STORAGE_BUFFER 0x90D2
+#endif
+#ifndef GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS
+#define GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS 0x90D6
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+struct GLExtensions {
+	// Compute shaders, shader storage buffers and indirect draws (OpenGL 4.3)
+	static bool computeShaders;
+
+	// Shader storage buffers read by vertex shaders (OpenGL 4.3, which may support none)
+	static bool vertexStorageBuffers;
+
+	// Immutable buffer storage, allowing persistent mappings (OpenGL 4.4 or ARB_buffer_storage)
+	static bool bufferStorage;
+
+	// Adaptive vsync, a swap interval of -1 (WGL or GLX_EXT_swap_control_tear)
+	static bool swapControlTear;
+
+	// Must be called after GLAD, with the context current
+	static void Load();
+};
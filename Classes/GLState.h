@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <GLAD/glad.h>
+
+/**
+ * Shadows the OpenGL state the renderer changes most often (program, VAO, texture units,
+ * buffers, blending and depth) and drops calls that would not change it.
+ * Objects must be deleted through it, so a recycled name isn't mistaken for a bound one,
+ * and Reset must be called whenever a new context is made current.
+ * Buffers and capabilities start out unknown, except for blending and depth testing.
+**/
+class GLState {
+public:
+	static void Reset();
+
+	static void UseProgram(GLuint program);
+	static void BindVertexArray(GLuint VAO);
+	static void ActiveTexture(GLenum unit);
+	static void BindTexture(GLenum target, GLuint texture);
+	static void BindBuffer(GLenum target, GLuint buffer);
+	static void BindBufferBase(GLenum target, GLuint index, GLuint buffer);
+
+	static void Enable(GLenum capability);
+	static void Disable(GLenum capability);
+	static void BlendFunc(GLenum source, GLenum destination);
+	static void BlendFuncSeparate(GLenum source, GLenum destination, GLenum alphaSource, GLenum alphaDestination);
+	static void DepthMask(GLboolean write);
+	static void DepthFunc(GLenum function);
+
+	static void DeleteTextures(GLsizei count, const GLuint *textures);
+	static void DeleteVertexArrays(GLsizei count, const GLuint *VAOs);
+	static void DeleteBuffers(GLsizei count, const GLuint *buffers);
+
+	// Calls forwarded to OpenGL and calls dropped, since the last ResetCounters
+	static unsigned int issued, skipped;
+	static void ResetCounters();
+
+private:
+	static const GLuint UNKNOWN = 0xFFFFFFFF;
+	static const int TEXTURE_UNITS = 16;
+
+	static bool Changed(GLuint &current, GLuint value);
+	static void SetCapability(GLenum capability, bool enabled);
+
+	static GLuint program, VAO, activeTexture;
+	static GLuint textures[TEXTURE_UNITS];
+	static GLuint blendSource, blendDestination, alphaSource, alphaDestination;
+	static GLuint depthWrite, depthFunction;
+
+	// Element array bindings are VAO state, so they are only tracked until the next VAO bind
+	static std::map<GLenum, GLuint> buffers;
+	static std::map<GLenum, bool> capabilities;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vector>
+#include "./Shader.h"
+#include "./SpriteInstance.h"
+#include <GLM/glm.hpp>
+
+/**
+ * GPU-driven rendering of a large set of sprites sharing one texture.
+ * The instances live in a shader storage buffer; a compute shader culls them against
+ * the camera and compacts the visible ones, writing the instance count of an indirect
+ * draw command that is then issued without any CPU readback.
+ * Requires GLExtensions::computeShaders.
+**/
+class GPUCuller {
+public:
+	GPUCuller();
+
+	void Initialize(const std::vector<SpriteInstance> &instances, GLuint texture);
+	// The camera comes from the Frame uniform block
+	void Cull(GLfloat scroll);
+	// Depth in NDC, for Instanced.vs
+	void Draw(GLfloat scroll, GLfloat depth);
+
+	// Reads the visible count back from the GPU, stalling the pipeline - only meant for stats
+	GLuint VisibleCount();
+
+	GLuint InstanceCount();
+
+private:
+	// Matches the layout of glDrawElementsIndirect commands
+	struct DrawElementsIndirectCommand {
+		GLuint count, instanceCount, firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	Shader *cullShader, *drawShader;
+
+	GLuint instanceBuffer, visibleBuffer, commandBuffer;
+	GLuint VAO, texture, instanceCount;
+};
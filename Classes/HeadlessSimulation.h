@@ -0,0 +1,43 @@
+#pragma once
+
+#include "./Simulation.h"
+#include "./InputRecording.h"
+#include "./JobSystem.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * Runs sessions of the game's simulation alone, with no window or OpenGL context, as fast as the
+ * steps go, for bots, balance tests and regression replays. Each session has its own Simulation
+ * and input, so sessions run in parallel as jobs, and the throughput is reported in steps per second.
+ * Sessions replay a recording (see InputRecording) or, without one, are played by a seeded bot.
+**/
+class HeadlessSimulation {
+public:
+	// Outcome of one session
+	struct Session {
+		unsigned long long steps;
+		unsigned int deaths;
+		SceneState state;
+	};
+
+	HeadlessSimulation();
+
+	// Bot sessions run the given steps with seeds following seed, replays run to the recording's end
+	void Run(int sessions, unsigned long long steps, string replay, unsigned int seed, JobSystem *jobs);
+
+	// Totals and throughput of the last Run
+	void Report();
+
+	const vector<Session> &Sessions();
+
+private:
+	void Play(Session &session, unsigned long long steps, unsigned int seed);
+	void Replay(Session &session, InputRecording &recording);
+
+	vector<Session> sessions;
+	bool replayed;
+	double seconds;
+};
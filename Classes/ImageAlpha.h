@@ -0,0 +1,23 @@
+#pragma once
+
+/**
+ * Alpha analysis of decoded images, run once at load so the renderer knows which textures
+ * can be drawn without blending, and so with depth writes, in the opaque pass of RenderQueue.
+**/
+class ImageAlpha {
+public:
+	// Whether every pixel is fully opaque, images without an alpha channel always are
+	static bool Opaque(const unsigned char *pixels, int width, int height, int channels) {
+		if (!pixels || channels != 4)
+			return pixels != 0;
+
+		const unsigned char *alpha = pixels + 3;
+		const unsigned char *end = pixels + (size_t)width * height * 4;
+
+		for (; alpha < end; alpha += 4)
+			if (*alpha != 255)
+				return false;
+
+		return true;
+	}
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// Key press or release, stamped with the simulation's clock when it reached the callback
+struct InputEvent {
+	double time;
+	int key, action;
+};
+
+/**
+ * Fixed size ring of input events, written by one thread (the GLFW callbacks) and read by
+ * another (the simulation), with no locks: each side only writes its own index, and publishes
+ * it with release ordering after the event it covers, so the other side sees complete events.
+ * Events keep the order they were pushed in; a full ring drops new events instead of blocking.
+**/
+class InputQueue {
+public:
+	// Power of two, so indices wrap with a mask
+	static const size_t CAPACITY = 256;
+
+	InputQueue();
+
+	// Producer only, false if the ring is full
+	bool Push(const InputEvent &event);
+
+	// Consumer only, the oldest event without removing it, false if there is none
+	bool Peek(InputEvent &event);
+	void Pop();
+
+	// Events dropped because the ring was full
+	unsigned int Dropped();
+
+private:
+	InputEvent events[CAPACITY];
+
+	// Each index on its own cache line, so the two threads don't keep stealing it from each other
+	alignas(64) std::atomic<size_t> head;
+	alignas(64) std::atomic<size_t> tail;
+	std::atomic<unsigned int> dropped;
+};
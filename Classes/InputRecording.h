@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <fstream>
+
+using namespace std;
+
+/**
+ * Input of a play session, stored by simulation step so that replaying it drives the fixed step
+ * simulation through exactly the same states, however fast the steps are run.
+ * Binary file, little endian:
+ * 	"TGAI", version (1 byte), random seed (4 bytes), simulation step in seconds (8 byte double),
+ * 	options (1 byte: rewind, then instantRespawn, from the lowest bit), rewind memory in bytes and in steps (4 bytes each)
+ * 	Events: steps since the previous event and key (both LEB128 varints), then the GLFW action (1 byte)
+ * 	A last event with action END gives the step the session ended on
+**/
+class InputRecording {
+public:
+	static const unsigned char END = 0xFF;
+
+	// Settings the simulation's states depend on besides its input, recorded so replays go through the same ones
+	struct Options {
+		bool rewind, instantRespawn;
+		unsigned int rewindMemory, rewindSteps;
+	};
+
+	InputRecording();
+	~InputRecording();
+
+	// Recording, events must come in step order
+	bool Create(string filename, unsigned int seed, double step, const Options &options);
+	void Record(unsigned long long step, int key, int action);
+	void Close(unsigned long long step);
+
+	// Replay, the whole file is read at once
+	bool Open(string filename);
+	unsigned int Seed();
+	double Step();
+	const Options &RecordedOptions();
+
+	// Next event recorded for the step, false once the step has no more
+	bool Next(unsigned long long step, int &key, int &action);
+
+	// Whether the session ended before the step
+	bool Finished(unsigned long long step);
+
+private:
+	void WriteVarint(unsigned long long value);
+	bool ReadVarint(unsigned long long &value);
+
+	// Decodes the next event into nextStep, nextKey and nextAction
+	void Advance();
+
+	ofstream output;
+	unsigned long long lastStep;
+
+	vector<unsigned char> data;
+	size_t position;
+	unsigned long long nextStep;
+	int nextKey, nextAction;
+
+	unsigned int seed;
+	double step;
+	Options options;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+using namespace std;
+
+/**
+ * Pool of worker threads running small jobs, each worker with its own deque of jobs.
+ * Workers push and pop jobs at the back of their own deque, most recent first, which keeps
+ * the data of related jobs in cache; idle workers steal from the front of the others' deques,
+ * taking the oldest (and usually largest) jobs. Jobs scheduled from outside the pool are
+ * spread over the workers' deques in turn.
+ * Counters track groups of jobs: Wait runs other jobs until a counter reaches zero, instead
+ * of blocking, and jobs can be scheduled to start only once a counter reaches zero.
+**/
+class JobSystem {
+public:
+	typedef function<void()> Job;
+
+	// Unfinished jobs of a group, and the jobs waiting for all of them
+	class Counter {
+	public:
+		Counter();
+
+		// Jobs scheduled with the counter that haven't finished yet
+		int Value();
+
+	private:
+		friend class JobSystem;
+
+		struct Continuation {
+			Job job;
+			Counter *counter;
+		};
+
+		atomic<int> count;
+		mutex lock;
+		vector<Continuation> waiting;
+	};
+
+	JobSystem();
+	~JobSystem();
+
+	// 0 workers starts one per core but the calling thread's, at least one
+	void Start(int workers);
+
+	// Jobs not started yet are run by the calling thread, so every counter is released
+	void Stop();
+
+	int Workers();
+
+	// The counter (if any) counts the job until it has run
+	void Schedule(Job job, Counter *counter = NULL);
+
+	// Same, but the job only starts once the dependency reaches zero
+	void ScheduleAfter(Counter &dependency, Job job, Counter *counter = NULL);
+
+	// Runs queued jobs until the counter reaches zero, also from threads outside the pool
+	void Wait(Counter &counter);
+
+	// Calls function(begin, end) over [0, count) in ranges of grain items, and waits for all of them
+	void ParallelFor(size_t count, size_t grain, function<void(size_t begin, size_t end)> function);
+
+private:
+	struct Entry {
+		Job job;
+		Counter *counter;
+	};
+
+	struct Worker {
+		mutex lock;
+		deque<Entry> jobs;
+	};
+
+	void Push(const Entry &entry);
+	bool Pop(int worker, Entry &entry);
+	bool Steal(int thief, Entry &entry);
+	void Run(Entry &entry);
+	void Work(int worker);
+
+	vector<Worker*> workers;
+	vector<thread> threads;
+
+	// Jobs queued in any deque, so idle workers only sleep when there is nothing to steal
+	atomic<int> queued;
+	atomic<bool> running;
+	atomic<unsigned int> nextWorker;
+
+	mutex sleepLock;
+	condition_variable wake;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include "./Shader.h"
+
+/**
+ * Offscreen target a parallax layer is drawn into at a fraction of the window's resolution,
+ * then composited over the frame with a bilinear upscale by a single screen covering triangle.
+ * Targets are cleared to transparent, and RenderQueue's blending accumulates alpha as coverage,
+ * so they hold premultiplied colors and composite without dark fringes around translucent edges.
+**/
+class LayerTarget {
+public:
+	LayerTarget();
+
+	// Targets at a scale of 1 (or more) are never created, and their layer is drawn directly
+	void Create(GLfloat scale, GLuint width, GLuint height);
+	void Resize(GLuint width, GLuint height);
+	bool Enabled();
+
+	// Binds the target and its viewport, and clears it
+	void Begin();
+
+	// Back to the default framebuffer, at the window's viewport
+	void End(GLuint width, GLuint height);
+
+	// Draws the target over the current framebuffer at the given NDC depth, blending set by the caller is replaced
+	void Composite(GLfloat depth);
+
+private:
+	GLfloat scale;
+	GLuint framebuffer, texture, VAO;
+	GLsizei width, height;
+	Shader *shader;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <deque>
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <GLAD/glad.h>
+#include "./Tilemap.h"
+#include "./JobSystem.h"
+
+using namespace std;
+
+/**
+ * Loads the level in segments as the camera approaches them, and evicts them behind it.
+ * Jobs read and parse segment files and decode their textures; the main thread
+ * only integrates finished segments and uploads at most one texture per frame, so
+ * Update never waits on the disk.
+ *
+ * A level is a directory holding:
+ * 	level.txt - "<tileset> <columns> <rows> <tileSize> <originX> <originY>"
+ * 	<n>.segment - segment n, one tilemap chunk wide, starting at n = 0. Lines starting with
+ * 		"sprite <texture> <x> <y> <width> <height>" place a sprite relative to the segment's
+ * 		bottom left corner; all other lines are rows of tiles, top first, as in Tilemap files
+**/
+class LevelStreamer {
+public:
+	// Streamed sprite, positioned like the box: bottom center, before projection
+	struct Sprite {
+		GLuint textureSlot;
+		glm::vec2 position, size;
+	};
+
+	LevelStreamer();
+	~LevelStreamer();
+
+	// Segments are loaded by jobs, at most maxLoads at a time
+	bool Start(string directory, Tilemap *tilemap, GLfloat lookahead, size_t memoryCap, JobSystem *jobs, int maxLoads);
+	void Stop();
+
+	// Main thread, once per frame: schedules loads and evictions around the camera, integrates finished segments
+	void Update(GLfloat cameraX);
+
+	// Sprites of the loaded segments overlapping view whose texture is ready
+	void VisibleSprites(const AABB &view, vector<const Sprite*> &result);
+	GLuint Texture(GLuint slot);
+
+	// Whether the slot's texture has no transparent pixels, known once it is uploaded
+	bool TextureOpaque(GLuint slot);
+
+	unsigned int LoadedSegments();
+	unsigned int PendingSegments();
+
+	// Whether segments are still loading or textures waiting to be uploaded, so Update has work left
+	bool Busy();
+	size_t MemoryUsage();
+
+private:
+	struct Image {
+		string path;
+		unsigned char *data;
+		int width, height, channels;
+		bool opaque;
+	};
+
+	// Produced by the jobs
+	struct LoadedSegment {
+		int index;
+		vector<string> tileRows;
+		vector<string> spriteTextures;
+		vector<Sprite> sprites;
+		vector<Image> images;
+	};
+
+	struct Segment {
+		bool loaded;
+		vector<Sprite> sprites;
+		size_t bytes;
+	};
+
+	struct TextureSlot {
+		string path;
+		GLuint texture;
+		bool opaque;
+		unsigned int references;
+		size_t bytes;
+	};
+
+	void Load(int index);
+	void LoadSegment(int index, LoadedSegment &result);
+	void Integrate(LoadedSegment &loaded);
+	void Evict(int index);
+	void UploadTexture(Image &image);
+	GLuint AcquireTexture(string path);
+	void ReleaseTexture(GLuint slot);
+	int SegmentAt(GLfloat x);
+
+	Tilemap *tilemap;
+	string directory;
+	GLfloat lookahead, segmentWidth;
+	glm::vec2 origin;
+	size_t memoryCap, memoryUsage;
+
+	map<int, Segment> segments;
+	vector<TextureSlot> textures;
+	map<string, GLuint> textureSlots;
+	deque<Image> uploads;
+
+	// Decoded by a segment evicted before integrating, kept for the segments that skipped their decode
+	map<string, Image> pendingImages;
+
+	// Segments requested, waiting for one of the maxLoads jobs
+	deque<int> requested;
+	int maxLoads;
+
+	// Shared with the jobs
+	JobSystem *jobs;
+	JobSystem::Counter loads;
+	mutex lock;
+	vector<LoadedSegment> finished;
+	set<string> decodedTextures;
+	atomic<bool> running;
+};
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+#include "./SpatialGrid.h"
+#include "./SpriteBatch.h"
+
+/**
+ * Draw packets submitted during a frame, radix sorted by a 64-bit key and then executed.
+ * Packets are split in two passes by their blend mode:
+ * 	Opaque (BLEND_NONE), front to back with depth writes, so hidden fragments fail the depth test
+ * 	Blended, back to front over them, still depth tested but without writes
+ * Keys are built by Key, most significant field first:
+ * 	Pass (1 bit)
+ * 	Layer (8 bits), the explicit draw order, reversed in the opaque pass
+ * 	Opaque: program (8 bits), texture (16 bits), then depth (31 bits) front to back
+ * 	Blended: blend mode (2 bits), depth (29 bits) back to front, then program and texture
+ * Program and texture names are truncated in the key, which only affects grouping.
+ * The sort is stable, so packets with equal keys keep the order they were submitted in.
+ * Consecutive sprite packets sharing their state are merged into a single SpriteBatch draw,
+ * and all state goes through GLState, so only actual changes reach OpenGL. Large runs of them
+ * can be written into the batch by jobs (see SetJobs), still drawn by one call from this thread.
+ * Depth goes from 0 (nearest) to 1, and reaches the shaders as NDC through their "depth" uniform.
+**/
+class RenderQueue {
+public:
+	enum Blend {BLEND_NONE, BLEND_ALPHA, BLEND_ADDITIVE};
+
+	RenderQueue();
+
+	// Runs of at least minSprites sprites sharing their state are written by jobs, in ranges of grain sprites
+	void SetJobs(JobSystem *jobs, GLuint minSprites, GLuint grain);
+
+	void Clear();
+
+	// Quad or trimmed mesh (see SpriteMesh) with packed vertices (see SpriteVertex), drawn with indexCount indices from its VAO
+	void SubmitMesh(GLuint layer, Blend blend, GLfloat depth, GLuint program, GLuint texture, GLuint VAO, GLsizei indexCount, const AABB &bounds, glm::vec3 translation, glm::vec2 textureOffset);
+
+	// Quad before projection, added to the sprite batch
+	void SubmitSprite(GLuint layer, Blend blend, GLfloat depth, GLuint program, GLuint texture, const AABB &quad, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec3 translation);
+
+	// Anything else, drawn by the callback with the pass state already set, and given the NDC depth to draw at
+	void SubmitCustom(GLuint layer, Blend blend, GLfloat depth, std::function<void(GLfloat depth)> draw);
+
+	// Moves the layer's mesh and sprite packets already submitted, for state that changed after they were (see SceneManager::LateLatch)
+	void Latch(GLuint layer, glm::vec3 translation, glm::vec2 textureOffset);
+
+	// Sorts and draws the frame's packets, the batch must be between Begin and End
+	void Execute(SpriteBatch &batch);
+
+	// Packets executed and draw calls they were merged into, by the last Execute
+	unsigned int Packets();
+	unsigned int Draws();
+
+private:
+	enum Type {MESH, SPRITE, CUSTOM};
+
+	static GLuint64 Key(GLuint layer, Blend blend, GLuint program, GLuint texture, GLfloat depth);
+
+	struct Packet {
+		Type type;
+		Blend blend;
+		GLuint layer;
+		GLuint program, texture, VAO;
+		GLsizei indexCount;
+		AABB bounds;
+		GLfloat depth;
+		glm::vec3 translation;
+		glm::vec2 textureOffset, uvMin, uvMax;
+		std::function<void(GLfloat depth)> draw;
+	};
+
+	struct SortEntry {
+		GLuint64 key;
+		GLuint packet;
+	};
+
+	void Submit(GLuint layer, Blend blend, GLfloat depth, Packet &packet);
+	void Sort();
+
+	// Blending and depth writes of the packet's pass
+	void SetPass(Blend blend);
+
+	// Binds the packet's program, texture and pass state, and sets the Shader.vs uniforms
+	void Apply(const Packet &packet, const AABB &bounds);
+
+	// Whether a sprite packet can join the batch of the previous one
+	bool SameState(const Packet &a, const Packet &b);
+
+	// Adds the sprites of entries [first, last), which share their state, to the batch
+	void AddSprites(SpriteBatch &batch, size_t first, size_t last);
+
+	std::vector<Packet> packets;
+	std::vector<SortEntry> entries, scratch;
+	unsigned int draws;
+
+	JobSystem *jobs;
+	GLuint parallelSprites, parallelGrain;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <iostream>
+
+// Per-frame renderer counters, printed once per second when "showStats" is enabled
+struct RenderStats {
+	// Culling
+	unsigned int visibleSprites, culledSprites, gpuVisibleSprites;
+
+	// Tilemap
+	unsigned int visibleChunks, chunkRebuilds;
+
+	// Level streaming
+	unsigned int loadedSegments, pendingSegments;
+	size_t streamingMemory;
+
+	// Streamed vertex data written, what packing saved on it, and frames that waited on the GPU for their region
+	long vertexBytes, vertexBytesSaved;
+	unsigned int streamWaits;
+
+	// Render queue packets, and the draw calls they were merged into
+	unsigned int queuedPackets, queueDraws;
+
+	// GL state changes, forwarded and dropped by GLState
+	unsigned int stateCallsIssued, stateCallsSkipped;
+
+	// Dynamic resolution scale, and the smoothed GPU time (ms) it follows
+	float resolutionScale, gpuTime;
+
+	// Intervals between frames (ms): mean, standard deviation and worst, and frames late on the frame limiter
+	double frameInterval, frameJitter, worstFrameInterval;
+	unsigned int lateFrames;
+
+	// Time from input events to the swap of the first frame showing them (ms), summed and worst, and their count
+	double inputLatency, worstInputLatency;
+	unsigned int inputEvents;
+
+	// Rewind history: seconds and bytes held, and the time a step's capture takes (us)
+	double rewindSeconds, rewindCapture;
+	size_t rewindMemory;
+
+	// Reporting
+	unsigned int frames;
+	double lastReport;
+
+	RenderStats() : visibleSprites(0), culledSprites(0), gpuVisibleSprites(0), visibleChunks(0), chunkRebuilds(0), loadedSegments(0), pendingSegments(0), streamingMemory(0), vertexBytes(0), vertexBytesSaved(0), streamWaits(0), queuedPackets(0), queueDraws(0), stateCallsIssued(0), stateCallsSkipped(0), resolutionScale(1.0f), gpuTime(0.0f), frameInterval(0.0), frameJitter(0.0), worstFrameInterval(0.0), lateFrames(0), inputLatency(0.0), worstInputLatency(0.0), inputEvents(0), rewindSeconds(0.0), rewindCapture(0.0), rewindMemory(0), frames(0), lastReport(0.0) {}
+
+	// Whether the next Report call will print, for counters that are costly to gather
+	bool Due(double now) {
+		return now - lastReport >= 1.0;
+	}
+
+	void Report(double now) {
+		frames++;
+
+		double elapsed = now - lastReport;
+		if (elapsed < 1.0)
+			return;
+
+		std::cout << "FPS: " << frames / elapsed
+			<< " | Sprites: " << visibleSprites << " visible, " << culledSprites << " culled"
+			<< " | Chunks: " << visibleChunks << " visible, " << chunkRebuilds << " built"
+			<< " | Segments: " << loadedSegments << " loaded, " << pendingSegments << " pending, "
+			<< streamingMemory / (1024.0 * 1024.0) << " MB"
+			<< " | Streamed: " << vertexBytes << " bytes (" << vertexBytesSaved << " saved), " << streamWaits << " waits"
+			<< " | Queue: " << queuedPackets << " packets, " << queueDraws << " draws"
+			<< " | State calls: " << stateCallsIssued << " issued, " << stateCallsSkipped << " skipped"
+			<< " | Resolution: " << resolutionScale * 100.0f << "%, GPU " << gpuTime << " ms"
+			<< " | Pacing: " << frameInterval << " ms, jitter " << frameJitter << " ms, worst " << worstFrameInterval << " ms, " << lateFrames << " late"
+			<< " | Input latency: " << (inputEvents ? inputLatency / inputEvents : 0.0) << " ms, worst " << worstInputLatency << " ms, " << inputEvents << " events"
+			<< " | Rewind: " << rewindSeconds << " s, " << rewindMemory / 1024.0 << " KB, capture " << rewindCapture << " us"
+			<< std::endl;
+
+		frames = 0;
+		inputLatency = worstInputLatency = 0.0;
+		inputEvents = 0;
+		lastReport = now;
+	}
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "./Simulation.h"
+#include <vector>
+
+using namespace std;
+
+/**
+ * History of the last steps of a Simulation, as checkpoints taken after each step, rewound one step at a time.
+ * Every KEYFRAME_INTERVAL steps a checkpoint is kept whole, and the ones in between as their XOR with that keyframe,
+ * which is zero but for the few bytes that moved; both are stored with their runs of zeros collapsed.
+ * Entries go one after the other into a ring of bytes allocated by Create, so capturing never allocates. The oldest
+ * keyframe is dropped with its deltas whenever the memory cap or the step count would be exceeded.
+ * Encoding: pairs of a count of zero bytes and a count of literal bytes (1 byte each), followed by the literals.
+**/
+class RewindBuffer {
+public:
+	static const int KEYFRAME_INTERVAL = 60;
+
+	RewindBuffer();
+
+	// Memory in bytes, history in steps
+	void Create(size_t memory, size_t steps);
+	void Clear();
+
+	void Push(const Simulation::Checkpoint &checkpoint);
+
+	// Newest checkpoint, which is removed from the history, false once there is none left
+	bool Pop(Simulation::Checkpoint &checkpoint);
+
+	size_t States();
+
+	// Bytes held by the stored entries, at most the memory given to Create
+	size_t Memory();
+
+	// Smoothed time Push takes, in microseconds
+	double CaptureTime();
+
+private:
+	struct Entry {
+		size_t offset, size;
+		bool keyframe;
+	};
+
+	// Oldest entry first
+	Entry &At(size_t index);
+
+	// Encodes data XOR base into scratch, returning its size
+	size_t Encode(const unsigned char *data, const unsigned char *base);
+	void Decode(const Entry &entry, const unsigned char *base, unsigned char *data);
+
+	// Where size bytes fit after the newest entry, without overwriting any, false if they don't
+	bool Fits(size_t size, size_t &offset);
+
+	// Drops the oldest keyframe and its deltas
+	void Evict();
+
+	vector<unsigned char> bytes, scratch;
+	vector<Entry> entries;
+	size_t first, count, tail, used;
+
+	// Keyframe of the newest entries, and the entries since it (itself included)
+	Simulation::Checkpoint keyframe;
+	int sinceKeyframe;
+
+	double captureTime;
+};
@@ -1,10 +1,56 @@
 #pragma once
 
 #include "./Shader.h"
+#include "./Settings.h"
+#include "./SpatialGrid.h"
+#include "./RenderStats.h"
+#include "./GPUCuller.h"
+#include "./Tilemap.h"
+#include "./LevelStreamer.h"
+#include "./FrameUniforms.h"
+#include "./SpriteBatch.h"
+#include "./RenderQueue.h"
+#include "./SpriteMesh.h"
+#include "./DynamicResolution.h"
+#include "./LayerTarget.h"
+#include "./FrameLimiter.h"
+#include "./InputQueue.h"
+#include "./InputRecording.h"
+#include "./SceneState.h"
+#include "./Simulation.h"
+#include "./HeadlessSimulation.h"
+#include "./RewindBuffer.h"
+#include "./TripleBuffer.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
 #include <GLM/glm.hpp>
 #include <GLM/gtc/matrix_transform.hpp>
 #include <GLM/gtc/type_ptr.hpp>
 
+// Objects drawn by the scene, also used as their ids in the culling grid
+enum SceneObject {
+	BACKGROUND,
+	FOREGROUND,
+	CHARACTER,
+	BOX,
+	SCENE_OBJECTS
+};
+
+// Draw order, also giving each layer its depth (see LayerDepth)
+enum SceneLayer {
+	BACKGROUND_LAYER,
+	FOREGROUND_LAYER,
+	TILEMAP_LAYER,
+	STREAMED_LAYER,
+	BENCHMARK_LAYER,
+	CHARACTER_LAYER,
+	BOX_LAYER
+};
+
+// Parallax layers come first, and can be drawn at a reduced resolution (see LayerTarget)
+static const int PARALLAX_LAYERS = FOREGROUND_LAYER + 1;
+
 class SceneManager {
 public:
 	SceneManager();
@@ -17,17 +63,69 @@ public:
 	//GLFW callbacks
 	static void KeyCallback(GLFWwindow* window, int key, int scanCode, int action, int mode);
 	static void Resize(GLFWwindow* window, int width, int height);
+	static void Refresh(GLFWwindow* window);
+
+	// Runs the fixed steps due by time, each one with the input events that happened before its end
+	void Simulate(double time);
 
+	// One fixed step, ending the replay (if any) once it has no more steps
+	void Step();
+	void ConsumeInput(double time);
+
+	// One step of the simulation, moving on to a respawn if the character died
 	void DoMovement();
-	bool TestCollision();
+	void Respawn();
+
+	// Polls and simulates once more right before the final draws, and moves the queued draws to match
+	void LateLatch();
+
+	// Whether anything drawn changed since the last call, also remembering the current state
+	bool SceneChanged();
+
+	// Snapshot of the simulation for a frame, taking the input counted since the previous one
+	SceneSnapshot Capture();
+
+	// Makes the snapshot the one frames are drawn from
+	void TakeFrame(const SceneSnapshot &snapshot);
 	
+	void CullScene();
+	void RebuildCullingGrid();
+	AABB ProjectBounds(const AABB &bounds, glm::vec2 translation);
+	AABB ViewBounds(GLfloat scroll);
+	AABB UnprojectBounds(const AABB &bounds);
+
+	// Blend mode of a texture's draws, opaque ones go to the queue's depth tested opaque pass when enabled
+	RenderQueue::Blend TextureBlend(bool opaque);
+
 	void Render();
 	void RenderBackground();
 	void RenderForeground();
 	void RenderCharacter();
 	void RenderBox();
+	void RenderBenchmarkSprites();
+	void RenderTilemap();
+	void RenderStreamedSprites();
+	void RenderLayerTargets();
+
+	// Queue a layer's draws go to, its own one when it is drawn at a reduced resolution
+	RenderQueue &LayerQueue(SceneLayer layer);
 
 	void Run();
+
+	// Simulation and rendering one after the other, on the main thread
+	void RunSerial();
+
+	// Simulation on the main thread, rendering on its own thread owning the context, handed snapshots
+	void RunThreaded();
+	void StartRenderThread();
+	void StopRenderThread();
+	void RenderLoop();
+
+	// Simulation sessions alone, without a window, as fast as possible (see HeadlessSimulation)
+	void RunHeadless();
+
+	// Draws the current frame, swaps and paces it
+	void DrawFrame();
 	void Finish();
 
 	void SetupScene();
@@ -35,6 +133,10 @@ public:
 	void SetupForeground();
 	void SetupCharacter();
 	void SetupBox();
+	void SetupBenchmarkSprites();
+	void SetupSpriteBatch();
+	void SetupTilemap();
+	void SetupLevelStreaming();
 	
 	void SetupBackgroundTexture();
 	void SetupForegroundTexture();
@@ -42,24 +144,132 @@ public:
 	void SetupBoxTexture();
 
 	void SetupCamera2D();
+	void SetupFramePacing();
 
 private:
-	GLfloat x, y, backgroundPosition, foregroundPosition, characterPosition, boxPosition, verticalPosition, offsetX, offsetY;
+	GLfloat x, y;
+
+	// Simulated, and drawn by the current frame
+	Simulation simulation;
+	SceneSnapshot frame;
+
+	// Where deaths respawn, restored instead of recreating the window and its resources when instantRespawn is set
+	bool instantRespawn;
+	Simulation::Checkpoint spawn;
+
+	// Optional history of the states before each step, stepped back through while the rewind key is held
+	bool rewind;
+	RewindBuffer history;
+
+	// Window size the camera and targets were last set up for
+	GLuint viewWidth, viewHeight;
 
 	unsigned int backgroundTexture, foregroundTexture, characterTexture, boxTexture, timer;
 
 	GLFWwindow *window;
 	
 	Shader *shader;
+
+	Settings settings;
+	
+	// Culling - level objects scroll with the foreground and are indexed in level coordinates
+	SpatialGrid levelGrid;
+	AABB objectBounds[SCENE_OBJECTS];
+	bool objectOpaque[SCENE_OBJECTS];
+	bool visible[SCENE_OBJECTS];
+	std::vector<unsigned int> visibleLevelObjects;
+
+	// Benchmark sprites - extra boxes scattered along the level, ids follow SCENE_OBJECTS in the grid
+	std::vector<SpriteInstance> benchmarkSprites;
+	std::vector<unsigned int> visibleBenchmarkSprites;
+
+	// Sprites rebuilt every frame, streamed through a triple-buffered vertex buffer, or pulled from a storage buffer
+	bool pulledSprites;
+	SpriteBatch spriteBatch;
+	Shader *batchShader;
+
+	// Level geometry, scrolls with the foreground
+	Tilemap tilemap;
+
+	// Workers shared by the engine's subsystems
+	JobSystem jobs;
+
+	// Optional level streaming, feeding the tilemap and its own sprites
+	bool streaming;
+	LevelStreamer streamer;
+	std::vector<const LevelStreamer::Sprite*> visibleStreamedSprites;
+
+	// Optional GPU-driven path for the benchmark sprites
+	bool gpuCulling;
+	GPUCuller gpuCuller;
+
+	// Draws submitted by the Render* functions, sorted and executed at the end of Render
+	bool opaquePass;
+	RenderQueue renderQueue;
+
+	// Parallax layers drawn at a reduced resolution, through their own queue and target
+	LayerTarget layerTargets[PARALLAX_LAYERS];
+	RenderQueue layerQueues[PARALLAX_LAYERS];
+
+	// Optional offscreen rendering at a resolution following the GPU time
+	bool dynamicResolution;
+	DynamicResolution resolution;
+
+	// Fixed step simulation, behind the frame's time by less than a step
+	double simulationTime, simulationStep;
+	bool respawn;
+
+	// Steps run since the start, across respawns, which recorded input is indexed by
+	unsigned long long stepCount;
+
+	// Optional recording or replay of the session's input
+	InputRecording recording;
+	bool recordInput, replayInput, replayFast;
+	std::chrono::steady_clock::time_point replayStart;
+
+	// Seed of everything random in the scene
+	unsigned int seed;
+
+	// Only simulating, no window is ever created
+	bool headless;
+
+	// Input consumed since the last presented frame: count, and sum and oldest of their timestamps
+	bool lateLatch;
+	unsigned int inputEvents;
+	double inputTimeSum, oldestInput;
+
+	// Optional skipping of frames identical to the last one, waiting for events instead
+	bool idleFrameSkipping;
+	GLfloat idleTimeout;
+	SceneState lastState;
+
+	// Optional render thread, drawing the snapshots published by the simulation
+	bool renderThread;
+	thread renderer;
+	std::atomic<bool> rendering;
+	TripleBuffer<SceneSnapshot> snapshots;
+
+	// Swap interval and optional frame rate limit, frames are paced after each swap
+	FrameLimiter limiter;
+
+	RenderStats stats;
 	
 	// Scene attributes
 	GLuint bgVAO, fgVAO, charVAO, boxVAO;
+	GLsizei objectIndices[SCENE_OBJECTS];
+
+	// Mostly transparent sprites are drawn through meshes trimmed to their visible pixels
+	SpriteMesh foregroundMesh, characterMesh;
 	
 	// Transformations - Model Matrix
 	glm::mat4 model;
 	
-	// 2D Camera - Projection matrix
-	glm::mat4 projection;
+	// 2D Camera - Projection and view matrices
+	glm::mat4 projection, inverseProjection, view;
+
+	// Camera and time data shared by every shader
+	FrameUniforms frameUniforms;
+	GLfloat lastFrameTime;
 	
 	// Translation
 	glm::mat4 translation;
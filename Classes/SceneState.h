@@ -0,0 +1,33 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <cstddef>
+
+// Everything the simulation changes, and frames are drawn from
+struct SceneState {
+	GLfloat backgroundPosition, foregroundPosition, characterPosition, boxPosition, verticalPosition, offsetX, offsetY;
+
+	bool operator!=(const SceneState &other) const {
+		return backgroundPosition != other.backgroundPosition
+			|| foregroundPosition != other.foregroundPosition
+			|| characterPosition != other.characterPosition
+			|| boxPosition != other.boxPosition
+			|| verticalPosition != other.verticalPosition
+			|| offsetX != other.offsetX
+			|| offsetY != other.offsetY;
+	}
+};
+
+// State handed from the simulation to rendering, with the window size and the input it includes
+struct SceneSnapshot : SceneState {
+	GLuint width, height;
+
+	// Input events consumed since the previous snapshot: count, and sum and oldest of their timestamps
+	unsigned int inputEvents;
+	double inputTimeSum, oldestInput;
+
+	// Rewind history held as of the snapshot: steps, bytes, and smoothed capture time in microseconds
+	unsigned int rewindStates;
+	size_t rewindMemory;
+	double rewindCapture;
+};
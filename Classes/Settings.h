@@ -0,0 +1,23 @@
+#pragma once
+
+#include <map>
+#include <string>
+
+using namespace std;
+
+/**
+ * Reads the flat "key": value pairs of Settings/Settings.json.
+ * Missing keys (or a missing file) fall back to the defaults given by the caller.
+**/
+class Settings {
+public:
+	void Load(string filename);
+
+	bool GetBool(string key, bool fallback);
+	int GetInt(string key, int fallback);
+	float GetFloat(string key, float fallback);
+	string GetString(string key, string fallback);
+
+private:
+	map<string, string> values;
+};
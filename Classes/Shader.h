@@ -8,6 +8,9 @@
 #include <GLAD/glad.h>
 #include <GLFW/glfw3.h>
 #include "STB_Image.h"
+#include "GLExtensions.h"
+#include "GLState.h"
+#include "FrameUniforms.h"
 
 using namespace std;
 
@@ -90,12 +93,69 @@ public:
 			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
 		}
 
+		BindFrameUniforms();
+
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
 	}
 
+	// Compute shader program - requires GLExtensions::computeShaders
+	Shader(const GLchar* computePath) {
+		std::string computeCode;
+		std::ifstream cShaderFile;
+
+		cShaderFile.exceptions(std::ifstream::badbit);
+		try {
+			cShaderFile.open(computePath);
+			std::stringstream cShaderStream;
+			cShaderStream << cShaderFile.rdbuf();
+			cShaderFile.close();
+			computeCode = cShaderStream.str();
+		} catch (const std::ifstream::failure &e) {
+			std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+		}
+
+		const GLchar* cShaderCode = computeCode.c_str();
+
+		GLuint compute;
+		GLint success;
+		GLchar infoLog[512];
+
+		compute = glCreateShader(GL_COMPUTE_SHADER);
+		glShaderSource(compute, 1, &cShaderCode, NULL);
+		glCompileShader(compute);
+
+		glGetShaderiv(compute, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(compute, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::COMPUTE::COMPILATION_FAILED\n" << infoLog << std::endl;
+		}
+
+		this->Program = glCreateProgram();
+		glAttachShader(this->Program, compute);
+		glLinkProgram(this->Program);
+
+		glGetProgramiv(this->Program, GL_LINK_STATUS, &success);
+		if (!success) {
+			glGetProgramInfoLog(this->Program, 512, NULL, infoLog);
+			std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+		}
+
+		BindFrameUniforms();
+
+		glDeleteShader(compute);
+	}
+
+	// Connects the program's Frame uniform block, if it declares one, to the shared per-frame buffer
+	void BindFrameUniforms() {
+		GLuint block = glGetUniformBlockIndex(this->Program, "Frame");
+
+		if (block != GL_INVALID_INDEX)
+			glUniformBlockBinding(this->Program, block, FrameUniforms::BINDING);
+	}
+
 	void Use() {
-		glUseProgram(this->Program);
+		GLState::UseProgram(this->Program);
 	}
 };
 
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "./SceneState.h"
+
+/**
+ * Gameplay of the scene on its own, without windowing or rendering: the keys held, and the fixed
+ * step moving the character and scrolling the layers. Instances share nothing, so any number of
+ * them can be stepped at once, on any threads (see HeadlessSimulation).
+**/
+class Simulation {
+public:
+	// Keys are GLFW key codes below KEYS, actions GLFW_PRESS and GLFW_RELEASE
+	static const int KEYS = 1024;
+
+	static const unsigned int CHECKPOINT_VERSION = 1;
+
+	/**
+	 * Everything a step depends on, flat and without padding, so checkpoints can be copied, written
+	 * to disk or compared byte by byte. Keys are packed a bit each, 32 to a word.
+	 * The magic, version and size are checked on Load, so checkpoints of another build are refused.
+	**/
+	struct Checkpoint {
+		char magic[4];
+		unsigned int version, size;
+		SceneState state;
+		unsigned int keys[KEYS / 32], tapped[KEYS / 32];
+	};
+
+	Simulation();
+
+	// Back to the starting positions, letting go of the key that walks into the box
+	void Reset();
+
+	// Input for the next step, a key pressed and released before it still moves for that step
+	void Input(int key, int action);
+
+	// One step, false if the character died in it, after which only Reset brings it back
+	bool Step();
+
+	// Uses up the input of a step without moving, keys tapped in it are let go
+	void Pause();
+
+	// Copies the simulation into the checkpoint, nothing is allocated either way
+	void Save(Checkpoint &checkpoint);
+
+	// False for a checkpoint of another version, leaving the simulation as it was; without input, keys stay as they are
+	bool Load(const Checkpoint &checkpoint, bool input = true);
+
+	bool Held(int key);
+
+	// Pressed since the last step, even if already released
+	bool Tapped(int key);
+	const SceneState &State();
+
+	bool TestCollision();
+
+private:
+	SceneState state;
+
+	// Keys held as of the current step, and pressed during it even if already released
+	bool keys[KEYS], tapped[KEYS];
+};
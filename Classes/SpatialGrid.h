@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+#include <GLM/glm.hpp>
+
+// Axis-aligned bounding box, in the same units the sprites are translated with
+struct AABB {
+	glm::vec2 min, max;
+
+	AABB() {}
+	AABB(glm::vec2 min, glm::vec2 max) : min(min), max(max) {}
+
+	bool Intersects(const AABB &other) const {
+		return min.x <= other.max.x && max.x >= other.min.x
+			&& min.y <= other.max.y && max.y >= other.min.y;
+	}
+};
+
+/**
+ * Uniform grid of coarse cells used to find the objects overlapping an area
+ * (usually the camera view) without testing every object in the scene.
+ * Object ids are chosen by the caller and must be small, as they index the internal arrays.
+**/
+class SpatialGrid {
+public:
+	SpatialGrid(float cellSize = 1.0f);
+
+	void Clear();
+	void Insert(unsigned int id, const AABB &bounds);
+	void Remove(unsigned int id);
+	void Query(const AABB &area, std::vector<unsigned int> &result);
+
+	unsigned int Size();
+
+private:
+	long long CellKey(int x, int y);
+	void CellRange(const AABB &area, int &xMin, int &yMin, int &xMax, int &yMax);
+
+	float cellSize;
+	unsigned int size, queryStamp;
+
+	std::unordered_map<long long, std::vector<unsigned int>> cells;
+
+	// Indexed by object id
+	std::vector<AABB> bounds;
+	std::vector<bool> inserted;
+	std::vector<unsigned int> stamps;
+};
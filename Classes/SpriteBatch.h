@@ -0,0 +1,75 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+#include "./StreamBuffer.h"
+#include "./SpatialGrid.h"
+#include "./SpriteVertex.h"
+#include "./SpriteInstance.h"
+#include "./JobSystem.h"
+
+/**
+ * Collects sprite quads rebuilt every frame into a StreamBuffer and draws them in as few
+ * calls as possible. Vertices are packed SpriteVertex values, placed before projection
+ * within the frame's bounds, so Shader.vs draws them like any other quad once its
+ * "bounds" uniform is set to Bounds().
+ * When pulled, each quad is a single SpriteInstance in a shader storage buffer instead,
+ * expanded by Pulled.vs from gl_VertexID without vertex attributes or an index buffer.
+ * Requires GLExtensions::vertexStorageBuffers.
+**/
+class SpriteBatch {
+public:
+	SpriteBatch();
+
+	void Create(GLuint capacity, bool pulled);
+
+	// Area is the part of the level in view, quads reaching further than its size past it are clamped
+	void Begin(const AABB &area);
+
+	// Queues a quad, returns false once the frame's capacity is used up
+	bool Add(const AABB &bounds, glm::vec2 uvMin, glm::vec2 uvMax);
+
+	// Queues count quads given by fetch, written straight into the mapped buffer by jobs over ranges of grain quads
+	// Fetch is called from the workers, once per quad. Returns how many quads fit in the frame's capacity
+	GLuint AddParallel(GLuint count, JobSystem &jobs, GLuint grain, function<void(GLuint index, AABB &bounds, glm::vec2 &uvMin, glm::vec2 &uvMax)> fetch);
+
+	// Bounds the frame's positions are packed within
+	const AABB &Bounds();
+
+	// Draws the quads added since the last flush, with the current program (Shader.vs, or Pulled.vs when pulled) and texture
+	void Flush();
+
+	void End();
+
+	// Data written this frame, and how much less it is than the same quads as float vertices
+	GLsizeiptr VertexBytes();
+	GLsizeiptr VertexBytesSaved();
+
+	unsigned int StreamWaits();
+
+private:
+	static const GLsizei STRIDE = sizeof(SpriteVertex);
+
+	// Must match the binding of the Sprites block in Shaders/Pulled.vs
+	static const GLuint PULLED_BINDING = 3;
+
+	// Position and texture coordinates as floats
+	static const GLsizei FLOAT_STRIDE = 5 * sizeof(float);
+
+	// Bytes written per quad
+	GLsizeiptr SpriteBytes();
+
+	// Maps what's left of the frame's region if it isn't mapped yet, false if nothing is left
+	bool Map();
+
+	// Writes a quad at index in the mapped region, safe to call from several threads for different indices
+	void Write(GLuint index, const AABB &bounds, glm::vec2 uvMin, glm::vec2 uvMax);
+
+	StreamBuffer stream;
+	bool pulled;
+	GLuint VAO, EBO, capacity, added, pending;
+	GLintptr offset;
+	GLsizeiptr frameBytes;
+	AABB bounds;
+	void *writer;
+};
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/packing.hpp>
+
+/**
+ * Compact per-sprite record (32 bytes), laid out to match the std430 SpriteInstance
+ * struct declared in the instanced shaders. The quad spans [-size.x / 2, size.x / 2] x [0, size.y]
+ * around position, like the box and character quads.
+**/
+struct SpriteInstance {
+	// Translation, after projection for the GPU culler and before it for pulled SpriteBatch quads
+	glm::vec2 position;
+
+	// Quad extents before projection
+	glm::vec2 size;
+
+	// Texture rectangle, packed as two unorm16 pairs
+	GLuint uvMin, uvMax;
+
+	GLfloat layer;
+	GLuint flags;
+
+	SpriteInstance() {}
+
+	SpriteInstance(glm::vec2 position, glm::vec2 size, glm::vec2 uvMin, glm::vec2 uvMax, GLfloat layer) {
+		this -> position = position;
+		this -> size = size;
+		this -> uvMin = glm::packUnorm2x16(uvMin);
+		this -> uvMax = glm::packUnorm2x16(uvMax);
+		this -> layer = layer;
+		this -> flags = 0;
+	}
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+#include "./SpatialGrid.h"
+#include "./SpriteVertex.h"
+
+using namespace std;
+
+/**
+ * Alpha-trimmed mesh for the frames of a sprite sheet, built once at load so the transparent
+ * parts of a sprite are neither rasterized nor blended.
+ * Frames are split into a grid of cells, and the cells holding a visible pixel in any frame are
+ * kept, since the same mesh is drawn with every frame by moving the texture offset. Kept cells
+ * are then merged into rectangles, in runs along each row first.
+ * Rectangles go from (0, 0) at the bottom left of a frame to (1, 1) at its top right.
+**/
+class SpriteMesh {
+public:
+	SpriteMesh();
+
+	// Sheet of columns x rows frames, images without alpha or cells = 0 get a single rectangle covering the frame
+	void Trim(const unsigned char *pixels, int width, int height, int channels, int columns, int rows, int cells);
+
+	// Rectangles mapped onto a quad of 4 vertices of 8 floats, laid out as in the Setup* functions
+	void Build(const float *quad, const AABB &bounds, vector<SpriteVertex> &vertices, vector<GLuint> &indices);
+
+	// Share of the frame covered by the rectangles
+	GLfloat Coverage();
+
+	unsigned int RectangleCount();
+
+private:
+	vector<AABB> rectangles;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GLAD/glad.h>
+#include <GLM/glm.hpp>
+#include <GLM/gtc/packing.hpp>
+#include "./SpatialGrid.h"
+
+/**
+ * Packed sprite vertex, 12 bytes instead of the 8 floats of the Setup* arrays:
+ * 	Position, unorm16 within the quad or batch bounds given to the "bounds" uniform of Shader.vs
+ * 	Texture coordinates, unorm16
+ * 	Color, unorm8
+ * Quads are flat, so their z is left out and the whole draw is given a "depth" uniform instead.
+**/
+struct SpriteVertex {
+	GLushort position[2];
+	GLushort texCoord[2];
+	GLubyte color[4];
+
+	SpriteVertex() {}
+
+	SpriteVertex(glm::vec2 position, const AABB &bounds, glm::vec2 texCoord, glm::vec4 color) {
+		glm::vec2 size = bounds.max - bounds.min;
+
+		this -> position[0] = glm::packUnorm1x16(size.x > 0.0f ? (position.x - bounds.min.x) / size.x : 0.0f);
+		this -> position[1] = glm::packUnorm1x16(size.y > 0.0f ? (position.y - bounds.min.y) / size.y : 0.0f);
+		this -> texCoord[0] = glm::packUnorm1x16(texCoord.x);
+		this -> texCoord[1] = glm::packUnorm1x16(texCoord.y);
+
+		for (int i = 0; i < 4; i++)
+			this -> color[i] = glm::packUnorm1x8(color[i]);
+	}
+
+	// Points attributes 0 (position), 1 (color) and 2 (texture coords) at the bound array buffer
+	static void SetupAttributes() {
+		glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SpriteVertex), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SpriteVertex), (void*)(4 * sizeof(GLushort)));
+		glEnableVertexAttribArray(1);
+
+		glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SpriteVertex), (void*)(2 * sizeof(GLushort)));
+		glEnableVertexAttribArray(2);
+	}
+};
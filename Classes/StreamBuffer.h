@@ -0,0 +1,45 @@
+#pragma once
+
+#include <GLAD/glad.h>
+
+/**
+ * Buffer for data rewritten every frame, split into one region per frame in flight.
+ * Each region is guarded by a fence, so writing never waits on draws still reading it.
+ * With buffer storage support the buffer is mapped once, persistently and coherently;
+ * otherwise every Map maps the free part of the region unsynchronized, which the fences
+ * make just as safe.
+**/
+class StreamBuffer {
+public:
+	static const int REGIONS = 3;
+
+	StreamBuffer();
+
+	void Create(GLenum target, GLsizeiptr regionSize);
+
+	// Moves to the next region, waiting for the GPU only if it is still using it
+	void BeginFrame();
+
+	// Returns where up to maxBytes can be written, and their offset in the buffer - NULL once the region is full
+	void* Map(GLsizeiptr maxBytes, GLsizeiptr alignment, GLintptr &offset, GLsizeiptr &available);
+
+	// Must be called with the bytes actually written before drawing from them
+	void Unmap(GLsizeiptr written);
+
+	void EndFrame();
+
+	GLuint Buffer();
+
+	// Frames that had to wait for their region
+	unsigned int Waits();
+
+private:
+	GLenum target;
+	GLuint buffer;
+	GLsizeiptr regionSize, used;
+	int region;
+	bool persistent, mapped;
+	unsigned char *memory;
+	GLsync fences[REGIONS];
+	unsigned int waits;
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+#include <GLAD/glad.h>
+#include "./SpatialGrid.h"
+
+using namespace std;
+
+/**
+ * Tile-based level geometry. Tiles are grouped into square chunks, each owning a vertex
+ * buffer that is built once (GL_STATIC_DRAW) and only rebuilt after one of its tiles changes.
+ * Chunks are stored sparsely and looked up by coordinates, so drawing only touches the
+ * chunks under the camera, however long the level is.
+**/
+class Tilemap {
+public:
+	Tilemap();
+
+	// Map file: first line is "<tileset> <columns> <rows> <tileSize> <originX> <originY>", then one line per row of tiles (top first)
+	bool Load(string filename);
+	void Clear();
+
+	// Opaque tilesets are drawn in the opaque pass of RenderQueue, loaded ones are analysed
+	void SetTileset(GLuint texture, int columns, int rows, bool opaque = false);
+	void LoadTileset(string filename, int columns, int rows);
+	bool TilesetOpaque();
+	void SetTileSize(GLfloat tileSize);
+
+	// Bottom left corner of tile (0, 0), before projection
+	void SetOrigin(glm::vec2 origin);
+
+	// Tile indexes start at 0, empty tiles are -1
+	void SetTile(int x, int y, int tile);
+	int GetTile(int x, int y);
+	void RemoveChunk(int chunkX, int chunkY);
+
+	// Draws the chunks overlapping view (before projection) and returns how many were drawn
+	unsigned int Draw(const AABB &view);
+
+	unsigned int ChunkCount();
+	unsigned int Rebuilds();
+
+	// Tile index of a map file character, -1 for empty tiles
+	static int TileIndex(char c);
+
+	static const int CHUNK_SIZE = 16;
+
+private:
+	struct Chunk {
+		vector<short> tiles;
+		GLuint VAO, VBO;
+		GLsizei indexCount;
+		bool dirty;
+	};
+
+	long long ChunkKey(int chunkX, int chunkY);
+	void BuildChunk(int chunkX, int chunkY, Chunk &chunk);
+	void SetupIndices();
+	GLuint LoadTexture(string filename, bool &opaque);
+
+	map<long long, Chunk> chunks;
+
+	GLuint tileset, indexBuffer;
+	bool tilesetOpaque;
+	int columns, rows;
+	GLfloat tileSize;
+	glm::vec2 origin;
+	unsigned int rebuilds;
+};
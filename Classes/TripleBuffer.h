@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
+
+/**
+ * Hands values from one producer thread to one consumer thread without either one waiting on the other.
+ * Of the three slots, the producer writes one, the consumer reads another, and the third holds the
+ * latest published value; publishing and taking swap a slot with that one, through a single atomic
+ * index that also records whether it is fresh. A value published before the previous one was taken
+ * replaces it, so the consumer always gets the newest one.
+ * Waiting for a value is optional and is the only part using a lock.
+**/
+template <typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : back(0), middle(1), front(2), interrupted(false) {}
+
+	// Producer: the slot to write the next value into
+	T &Back() {
+		return slots[back];
+	}
+
+	// Producer: publishes Back, returns false if the previous value was replaced before being taken
+	bool Publish() {
+		int previous = middle.exchange(back | FRESH, std::memory_order_acq_rel);
+		back = previous & INDEX;
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+		}
+		wake.notify_one();
+
+		return !(previous & FRESH);
+	}
+
+	// Consumer: takes the latest value into Front, false if nothing was published since the last Take
+	bool Take() {
+		if (!(middle.load(std::memory_order_acquire) & FRESH))
+			return false;
+
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+
+	// Consumer: the value taken last
+	T &Front() {
+		return slots[front];
+	}
+
+	// Consumer: sleeps until a value is published, Interrupt is called or the timeout (in seconds) passes
+	void Wait(double timeout) {
+		std::unique_lock<std::mutex> guard(lock);
+
+		wake.wait_for(guard, std::chrono::duration<double>(timeout), [this] {
+			return (middle.load(std::memory_order_acquire) & FRESH) || interrupted;
+		});
+
+		interrupted = false;
+	}
+
+	// Wakes the consumer from Wait, e.g. to stop it
+	void Interrupt() {
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			interrupted = true;
+		}
+		wake.notify_one();
+	}
+
+private:
+	static const int INDEX = 3;
+	static const int FRESH = 4;
+
+	T slots[3];
+
+	// Producer's and consumer's slots, and the shared one with its fresh flag
+	int back;
+	std::atomic<int> middle;
+	int front;
+
+	std::mutex lock;
+	std::condition_variable wake;
+	bool interrupted;
+};
@@ -0,0 +1,12 @@
+#version 410
+
+in vec2 texture_coords;
+
+// Layer target, holding premultiplied colors (see LayerTarget)
+uniform sampler2D layer;
+
+out vec4 frag_color;
+
+void main () {
+	frag_color = texture (layer, texture_coords);
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#version 410
+
+out vec2 texture_coords;
+
+// NDC depth of the layer, as in Shader.vs
+uniform float depth;
+
+void main() {
+	// A single triangle covering the screen, from gl_VertexID 0, 1 and 2 without any vertex data
+	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+
+	texture_coords = corner;
+	gl_Position = vec4(corner * 2.0 - 1.0, depth, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#version 430 core
+layout (location = 0) in vec2 corner;
+
+struct SpriteInstance {
+	vec2 position;
+	vec2 size;
+	uint uvMin;
+	uint uvMax;
+	float layer;
+	uint flags;
+};
+
+// Visible instances, compacted by Cull.comp
+layout (std430, binding = 1) readonly buffer Visible {
+	SpriteInstance visible[];
+};
+
+out vec2 texture_coords;
+
+// Per-frame data, shared by every program (see FrameUniforms)
+layout (std140) uniform Frame {
+	mat4 projection;
+	mat4 view;
+	vec4 viewport;
+	float time;
+	float deltaTime;
+};
+
+uniform float scroll;
+
+// NDC depth of the whole draw, as in Shader.vs
+uniform float depth;
+
+void main() {
+	SpriteInstance sprite = visible[gl_InstanceID];
+
+	vec4 position = projection * view * vec4(corner * sprite.size, 0.0, 1.0);
+	gl_Position = vec4(position.xy + sprite.position + vec2(scroll, 0.0), depth * position.w, position.w);
+
+	vec2 uv = mix(unpackUnorm2x16(sprite.uvMin), unpackUnorm2x16(sprite.uvMax), vec2(corner.x + 0.5, corner.y));
+	// Same y-axis swap as Shader.vs
+	texture_coords = vec2(uv.x, 1.0 - uv.y);
+}
@@ -0,0 +1,49 @@
+#version 430 core
+
+struct SpriteInstance {
+	vec2 position;
+	vec2 size;
+	uint uvMin;
+	uint uvMax;
+	float layer;
+	uint flags;
+};
+
+// Sprites written by SpriteBatch, 6 vertices each, with no vertex attributes or indices
+layout (std430, binding = 3) readonly buffer Sprites {
+	SpriteInstance sprites[];
+};
+
+out vec2 texture_coords;
+
+uniform mat4 model;
+
+// NDC depth of the whole draw, as in Shader.vs
+uniform float depth;
+
+// Per-frame data, shared by every program (see FrameUniforms)
+layout (std140) uniform Frame {
+	mat4 projection;
+	mat4 view;
+	vec4 viewport;
+	float time;
+	float deltaTime;
+};
+
+// Quad corners, for the same two triangles as the scene quads' indices
+const vec2 corners[6] = vec2[](
+	vec2( 0.5, 1.0), vec2( 0.5, 0.0), vec2(-0.5, 1.0),
+	vec2( 0.5, 0.0), vec2(-0.5, 0.0), vec2(-0.5, 1.0)
+);
+
+void main() {
+	SpriteInstance sprite = sprites[gl_VertexID / 6];
+	vec2 corner = corners[gl_VertexID % 6];
+
+	gl_Position = model * projection * view * vec4(sprite.position + corner * sprite.size, 0.0, 1.0);
+	gl_Position.z = depth * gl_Position.w;
+
+	vec2 uv = mix(unpackUnorm2x16(sprite.uvMin), unpackUnorm2x16(sprite.uvMax), vec2(corner.x + 0.5, corner.y));
+	// Same y-axis swap as Shader.vs
+	texture_coords = vec2(uv.x, 1.0 - uv.y);
+}
\ No newline at end of file
@@ -1,5 +1,5 @@
 #version 430 core
-layout (location = 0) in vec3 position;
+layout (location = 0) in vec2 position;
 layout (location = 1) in vec3 color;
 layout (location = 2) in vec2 texCoord;
 
@@ -7,10 +7,25 @@ out vec3 ourColor;
 out vec2 texture_coords;
   
 uniform mat4 model;
-uniform mat4 projection;
+
+// Packed positions are normalized within these bounds (min in xy, max in zw), (0, 0, 1, 1) for float positions
+uniform vec4 bounds;
+
+// Quads are flat, so the whole draw is placed at a single NDC depth, set by RenderQueue
+uniform float depth;
+
+// Per-frame data, shared by every program (see FrameUniforms)
+layout (std140) uniform Frame {
+	mat4 projection;
+	mat4 view;
+	vec4 viewport;
+	float time;
+	float deltaTime;
+};
 
 void main() {
-    gl_Position = model * projection * vec4(position, 1.0f);
+    gl_Position = model * projection * view * vec4(mix(bounds.xy, bounds.zw, position), 0.0f, 1.0f);
+	gl_Position.z = depth * gl_Position.w;
 	ourColor = color;
 	// We swap the y-axis by substracing our coordinates from 1. This is done because most images have the top y-axis inversed with OpenGL's top y-axis.
 	texture_coords = vec2(texCoord.x, 1.0 - texCoord.y);
@@ -7,10 +7,18 @@ out vec3 ourColor;
 out vec2 TexCoord;
   
 uniform mat4 model;
-uniform mat4 projection;
+
+// Per-frame data, shared by every program (see FrameUniforms)
+layout (std140) uniform Frame {
+	mat4 projection;
+	mat4 view;
+	vec4 viewport;
+	float time;
+	float deltaTime;
+};
 
 void main() {
-    gl_Position = model * projection * vec4(position, 1.0f);
+    gl_Position = model * projection * view * vec4(position, 1.0f);
 	ourColor = color;
 	// We swap the y-axis by substracing our coordinates from 1. This is done because most images have the top y-axis inversed with OpenGL's top y-axis.
 	TexCoord = vec2(texCoord.x, 1.0 - texCoord.y);
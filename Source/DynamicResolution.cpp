@@ -0,0 +1,145 @@
+#include <Classes/DynamicResolution.h>
+#include <Classes/GLState.h>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// Frames under this share of the target time are cheap enough to raise the scale
+static const GLfloat HEADROOM = 0.8f;
+
+// Largest scale changes per measured frame, down and up, so resolution changes stay gradual
+static const GLfloat STEP_DOWN = 0.05f;
+static const GLfloat STEP_UP = 0.02f;
+
+DynamicResolution::DynamicResolution() {
+	framebuffer = 0;
+	colorBuffer = 0;
+	depthBuffer = 0;
+	query = 0;
+	width = height = renderWidth = renderHeight = 1;
+	scale = minScale = maxScale = 1.0f;
+	targetTime = 16.0f;
+	gpuTime = 0.0f;
+
+	for (int i = 0; i < QUERIES; i++) {
+		queries[i] = 0;
+		pending[i] = false;
+	}
+}
+
+void DynamicResolution::Create(GLuint width, GLuint height, GLfloat minScale, GLfloat maxScale, GLfloat targetTime) {
+	this -> minScale = std::max(std::min(minScale, maxScale), 0.1f);
+	this -> maxScale = std::max(maxScale, this -> minScale);
+	this -> targetTime = targetTime;
+	scale = this -> maxScale;
+
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+	glGenQueries(QUERIES, queries);
+
+	Resize(width, height);
+}
+
+void DynamicResolution::Resize(GLuint width, GLuint height) {
+	this -> width = std::max(width, 1u);
+	this -> height = std::max(height, 1u);
+
+	Allocate();
+}
+
+void DynamicResolution::Allocate() {
+	GLsizei maxWidth = std::max((GLsizei)ceil(width * maxScale), 1);
+	GLsizei maxHeight = std::max((GLsizei)ceil(height * maxScale), 1);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, maxWidth, maxHeight);
+
+	// The render queue depth tests its opaque pass
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, maxWidth, maxHeight);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Dynamic resolution framebuffer is incomplete" << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void DynamicResolution::Begin() {
+	renderWidth = Width();
+	renderHeight = Height();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, renderWidth, renderHeight);
+
+	// Keeps clears to the part of the framebuffer in use
+	GLState::Enable(GL_SCISSOR_TEST);
+	glScissor(0, 0, renderWidth, renderHeight);
+
+	glBeginQuery(GL_TIME_ELAPSED, queries[query]);
+}
+
+void DynamicResolution::End() {
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[query] = true;
+	query = (query + 1) % QUERIES;
+
+	// Blits are scissored too
+	GLState::Disable(GL_SCISSOR_TEST);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(0, 0, renderWidth, renderHeight, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	glViewport(0, 0, width, height);
+
+	// The oldest query is read if it is done, otherwise its result is dropped when the slot is reused
+	if (pending[query]) {
+		GLuint available = 0;
+		glGetQueryObjectuiv(queries[query], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (available) {
+			GLuint64 elapsed = 0;
+			glGetQueryObjectui64v(queries[query], GL_QUERY_RESULT, &elapsed);
+			pending[query] = false;
+			Control(elapsed / 1000000.0f);
+		}
+	}
+}
+
+void DynamicResolution::Control(GLfloat time) {
+	// Smoothed and clamped, so a single slow frame (or a bogus first query) doesn't change the resolution
+	time = std::min(time, 4.0f * targetTime);
+	gpuTime = gpuTime > 0.0f ? gpuTime + (time - gpuTime) * 0.1f : time;
+
+	if (gpuTime <= targetTime && gpuTime >= targetTime * HEADROOM)
+		return;
+
+	// GPU time mostly follows the pixel count, which goes with the square of the scale
+	GLfloat ideal = scale * sqrt(0.5f * (1.0f + HEADROOM) * targetTime / std::max(gpuTime, 0.001f));
+
+	scale = std::min(std::max(ideal, scale - STEP_DOWN), scale + STEP_UP);
+	scale = std::min(std::max(scale, minScale), maxScale);
+}
+
+GLuint DynamicResolution::Width() {
+	return std::max((GLuint)(width * scale + 0.5f), 1u);
+}
+
+GLuint DynamicResolution::Height() {
+	return std::max((GLuint)(height * scale + 0.5f), 1u);
+}
+
+GLfloat DynamicResolution::Scale() {
+	return scale;
+}
+
+GLfloat DynamicResolution::GPUTime() {
+	return gpuTime;
+}
@@ -0,0 +1,105 @@
+#include <Classes/FrameLimiter.h>
+#include <algorithm>
+#include <thread>
+#include <cmath>
+
+// Oversleeps fade out of the spin window slowly, one scheduler hiccup keeps it wide for a while
+static const double OVERSLEEP_DECAY = 0.99;
+
+// Largest spin window, a timer worse than this is waited on in a loop of short sleeps anyway
+static const double MAX_SPIN = 0.004;
+
+static double Seconds(std::chrono::steady_clock::duration duration) {
+	return std::chrono::duration<double>(duration).count();
+}
+
+FrameLimiter::FrameLimiter() {
+	frameTime = 0.0;
+	spinTime = oversleep = 0.0;
+	started = false;
+
+	ResetStats();
+}
+
+void FrameLimiter::Create(double frameTime, double spinTime) {
+	this -> frameTime = std::max(frameTime, 0.0);
+	this -> spinTime = std::min(std::max(spinTime, 0.0), MAX_SPIN);
+	oversleep = 0.0;
+	started = false;
+}
+
+void FrameLimiter::Wait() {
+	Clock::time_point now = Clock::now();
+	bool late = false;
+
+	if (frameTime > 0.0 && started) {
+		Clock::duration period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(frameTime));
+		deadline += period;
+		late = Seconds(now - deadline) > 0.5 * frameTime;
+
+		// Over a frame behind, the schedule starts over from now instead of rushing frames out to catch up
+		if (now > deadline + period)
+			deadline = now;
+
+		double spin = std::min(std::max(spinTime, oversleep), MAX_SPIN);
+		oversleep *= OVERSLEEP_DECAY;
+
+		while (Seconds(deadline - now) > spin) {
+			Clock::time_point wake = deadline - std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(spin));
+			std::this_thread::sleep_until(wake);
+
+			now = Clock::now();
+			oversleep = std::max(oversleep, Seconds(now - wake));
+		}
+
+		while (now < deadline) {
+			std::this_thread::yield();
+			now = Clock::now();
+		}
+	} else
+		deadline = now;
+
+	if (started) {
+		double interval = Seconds(now - lastFrame) * 1000.0;
+
+		intervals++;
+		intervalSum += interval;
+		intervalSquareSum += interval * interval;
+		worstInterval = std::max(worstInterval, interval);
+
+		if (late)
+			lateFrames++;
+	}
+
+	lastFrame = now;
+	started = true;
+}
+
+void FrameLimiter::Restart() {
+	started = false;
+}
+
+double FrameLimiter::MeanInterval() {
+	return intervals ? intervalSum / intervals : 0.0;
+}
+
+double FrameLimiter::Jitter() {
+	if (!intervals)
+		return 0.0;
+
+	double mean = MeanInterval();
+	return sqrt(std::max(intervalSquareSum / intervals - mean * mean, 0.0));
+}
+
+double FrameLimiter::WorstInterval() {
+	return worstInterval;
+}
+
+unsigned int FrameLimiter::LateFrames() {
+	return lateFrames;
+}
+
+void FrameLimiter::ResetStats() {
+	intervals = lateFrames = 0;
+	intervalSum = intervalSquareSum = worstInterval = 0.0;
+}
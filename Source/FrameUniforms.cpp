@@ -0,0 +1,29 @@
+#include <Classes/FrameUniforms.h>
+#include <Classes/GLState.h>
+
+FrameUniforms::FrameUniforms() {
+	UBO = 0;
+}
+
+void FrameUniforms::Create() {
+	glGenBuffers(1, &UBO);
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_STREAM_DRAW);
+
+	GLState::BindBufferBase(GL_UNIFORM_BUFFER, BINDING, UBO);
+}
+
+void FrameUniforms::Update(const glm::mat4 &projection, const glm::mat4 &view, GLuint width, GLuint height, GLfloat time, GLfloat deltaTime) {
+	Block block;
+	block.projection = projection;
+	block.view = view;
+	block.viewport = glm::vec4((float)width, (float)height, 1.0f / width, 1.0f / height);
+	block.time = time;
+	block.deltaTime = deltaTime;
+	block.padding[0] = block.padding[1] = 0.0f;
+
+	// Orphans the previous contents, so the driver doesn't wait for last frame's draws
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, UBO);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(Block), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Block), &block);
+}
@@ -0,0 +1,43 @@
+#include <Classes/GLExtensions.h>
+#include <GLFW/glfw3.h>
+#include <cstddef>
+
+PFNGLDRAWELEMENTSINDIRECTPROC glad_glDrawElementsIndirect = NULL;
+PFNGLMEMORYBARRIERPROC glad_glMemoryBarrier = NULL;
+PFNGLDISPATCHCOMPUTEPROC glad_glDispatchCompute = NULL;
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = NULL;
+
+bool GLExtensions::computeShaders = false;
+bool GLExtensions::vertexStorageBuffers = false;
+bool GLExtensions::bufferStorage = false;
+bool GLExtensions::swapControlTear = false;
+
+void GLExtensions::Load() {
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	int version = major * 10 + minor;
+
+	glad_glDrawElementsIndirect = (PFNGLDRAWELEMENTSINDIRECTPROC)glfwGetProcAddress("glDrawElementsIndirect");
+	glad_glMemoryBarrier = (PFNGLMEMORYBARRIERPROC)glfwGetProcAddress("glMemoryBarrier");
+	glad_glDispatchCompute = (PFNGLDISPATCHCOMPUTEPROC)glfwGetProcAddress("glDispatchCompute");
+	glad_glBufferStorage = (PFNGLBUFFERSTORAGEPROC)glfwGetProcAddress("glBufferStorage");
+
+	computeShaders = version >= 43
+		&& glad_glDrawElementsIndirect
+		&& glad_glMemoryBarrier
+		&& glad_glDispatchCompute;
+
+	GLint vertexStorageBlocks = 0;
+	if (version >= 43)
+		glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &vertexStorageBlocks);
+
+	vertexStorageBuffers = vertexStorageBlocks > 0;
+
+	bufferStorage = (version >= 44 || glfwExtensionSupported("GL_ARB_buffer_storage"))
+		&& glad_glBufferStorage;
+
+	swapControlTear = glfwExtensionSupported("WGL_EXT_swap_control_tear")
+		|| glfwExtensionSupported("GLX_EXT_swap_control_tear");
+}
@@ -0,0 +1,188 @@
+#include <Classes/GLState.h>
+
+GLuint GLState::program = GLState::UNKNOWN;
+GLuint GLState::VAO = GLState::UNKNOWN;
+GLuint GLState::activeTexture = GLState::UNKNOWN;
+GLuint GLState::textures[GLState::TEXTURE_UNITS];
+GLuint GLState::blendSource = GLState::UNKNOWN;
+GLuint GLState::blendDestination = GLState::UNKNOWN;
+GLuint GLState::alphaSource = GLState::UNKNOWN;
+GLuint GLState::alphaDestination = GLState::UNKNOWN;
+GLuint GLState::depthWrite = GLState::UNKNOWN;
+GLuint GLState::depthFunction = GLState::UNKNOWN;
+
+std::map<GLenum, GLuint> GLState::buffers;
+std::map<GLenum, bool> GLState::capabilities;
+
+unsigned int GLState::issued = 0;
+unsigned int GLState::skipped = 0;
+
+void GLState::Reset() {
+	// A new context starts with the OpenGL defaults
+	program = 0;
+	VAO = 0;
+	activeTexture = GL_TEXTURE0;
+	blendSource = GL_ONE;
+	blendDestination = GL_ZERO;
+	alphaSource = GL_ONE;
+	alphaDestination = GL_ZERO;
+	depthWrite = GL_TRUE;
+	depthFunction = GL_LESS;
+
+	for (int i = 0; i < TEXTURE_UNITS; i++)
+		textures[i] = 0;
+
+	buffers.clear();
+	capabilities.clear();
+	capabilities[GL_BLEND] = false;
+	capabilities[GL_DEPTH_TEST] = false;
+}
+
+void GLState::UseProgram(GLuint program) {
+	if (Changed(GLState::program, program))
+		glUseProgram(program);
+}
+
+void GLState::BindVertexArray(GLuint VAO) {
+	if (!Changed(GLState::VAO, VAO))
+		return;
+
+	glBindVertexArray(VAO);
+	buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+}
+
+void GLState::ActiveTexture(GLenum unit) {
+	if (Changed(activeTexture, unit))
+		glActiveTexture(unit);
+}
+
+void GLState::BindTexture(GLenum target, GLuint texture) {
+	// Only 2D textures are used, so units are tracked regardless of target
+	GLuint unit = activeTexture == UNKNOWN ? UNKNOWN : activeTexture - GL_TEXTURE0;
+
+	if (unit >= TEXTURE_UNITS) {
+		issued++;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	if (Changed(textures[unit], texture))
+		glBindTexture(target, texture);
+}
+
+void GLState::BindBuffer(GLenum target, GLuint buffer) {
+	auto current = buffers.find(target);
+
+	if (current != buffers.end() && current -> second == buffer) {
+		skipped++;
+		return;
+	}
+
+	issued++;
+	glBindBuffer(target, buffer);
+	buffers[target] = buffer;
+}
+
+void GLState::BindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+	// Indexed bindings aren't shadowed, but they also replace the generic binding
+	issued++;
+	glBindBufferBase(target, index, buffer);
+	buffers[target] = buffer;
+}
+
+void GLState::Enable(GLenum capability) {
+	SetCapability(capability, true);
+}
+
+void GLState::Disable(GLenum capability) {
+	SetCapability(capability, false);
+}
+
+void GLState::BlendFunc(GLenum source, GLenum destination) {
+	BlendFuncSeparate(source, destination, source, destination);
+}
+
+void GLState::BlendFuncSeparate(GLenum source, GLenum destination, GLenum alphaSource, GLenum alphaDestination) {
+	if (blendSource == source && blendDestination == destination && GLState::alphaSource == alphaSource && GLState::alphaDestination == alphaDestination) {
+		skipped++;
+		return;
+	}
+
+	issued++;
+	glBlendFuncSeparate(source, destination, alphaSource, alphaDestination);
+	blendSource = source;
+	blendDestination = destination;
+	GLState::alphaSource = alphaSource;
+	GLState::alphaDestination = alphaDestination;
+}
+
+void GLState::DepthMask(GLboolean write) {
+	if (Changed(depthWrite, write))
+		glDepthMask(write);
+}
+
+void GLState::DepthFunc(GLenum function) {
+	if (Changed(depthFunction, function))
+		glDepthFunc(function);
+}
+
+void GLState::DeleteTextures(GLsizei count, const GLuint *textures) {
+	for (GLsizei i = 0; i < count; i++)
+		for (int unit = 0; unit < TEXTURE_UNITS; unit++)
+			if (GLState::textures[unit] == textures[i])
+				GLState::textures[unit] = 0;
+
+	glDeleteTextures(count, textures);
+}
+
+void GLState::DeleteVertexArrays(GLsizei count, const GLuint *VAOs) {
+	for (GLsizei i = 0; i < count; i++)
+		if (VAO == VAOs[i]) {
+			VAO = 0;
+			buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+		}
+
+	glDeleteVertexArrays(count, VAOs);
+}
+
+void GLState::DeleteBuffers(GLsizei count, const GLuint *buffers) {
+	for (GLsizei i = 0; i < count; i++)
+		for (auto &binding : GLState::buffers)
+			if (binding.second == buffers[i])
+				binding.second = 0;
+
+	glDeleteBuffers(count, buffers);
+}
+
+void GLState::ResetCounters() {
+	issued = 0;
+	skipped = 0;
+}
+
+bool GLState::Changed(GLuint &current, GLuint value) {
+	if (current == value) {
+		skipped++;
+		return false;
+	}
+
+	issued++;
+	current = value;
+	return true;
+}
+
+void GLState::SetCapability(GLenum capability, bool enabled) {
+	auto current = capabilities.find(capability);
+
+	if (current != capabilities.end() && current -> second == enabled) {
+		skipped++;
+		return;
+	}
+
+	issued++;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+
+	capabilities[capability] = enabled;
+}
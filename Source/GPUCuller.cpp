@@ -0,0 +1,139 @@
+#include <Classes/GPUCuller.h>
+#include <cstddef>
+
+// Must match local_size_x in Shaders/Cull.comp
+static const GLuint CULL_GROUP_SIZE = 64;
+
+GPUCuller::GPUCuller() {
+	cullShader = NULL;
+	drawShader = NULL;
+	instanceCount = 0;
+}
+
+void GPUCuller::Initialize(const std::vector<SpriteInstance> &instances, GLuint texture) {
+	this -> texture = texture;
+	instanceCount = instances.size();
+
+	cullShader = new Shader("Shaders/Cull.comp");
+	drawShader = new Shader("Shaders/Instanced.vs", "Shaders/Shader.frag");
+
+	/** 
+	 * Unit quad shared by every instance, in order:
+	 * 	Top right
+	 * 	Bottom right
+	 * 	Bottom left
+	 * 	Top left
+	**/
+	float quad[] = {
+		 0.5f,	1.0f,
+		 0.5f,	0.0f,
+		-0.5f,	0.0f,
+		-0.5f,	1.0f
+	};
+
+	unsigned int indices[] = {
+		0, 1, 3,
+		1, 2, 3 
+	};
+
+	unsigned int quadVBO, quadEBO;
+
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &quadVBO);
+	glGenBuffers(1, &quadEBO);
+
+	GLState::BindVertexArray(VAO);
+
+	GLState::BindBuffer(GL_ARRAY_BUFFER, quadVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+	// Corner
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+
+	GLState::BindVertexArray(0);
+
+	// All instances, written once
+	glGenBuffers(1, &instanceBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, instanceBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(SpriteInstance), instances.data(), GL_STATIC_DRAW);
+
+	// Visible instances, compacted by the compute shader every frame
+	glGenBuffers(1, &visibleBuffer);
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, visibleBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, instances.size() * sizeof(SpriteInstance), NULL, GL_DYNAMIC_COPY);
+
+	// Indirect draw command, its instance count is written by the compute shader
+	DrawElementsIndirectCommand command = { 6, 0, 0, 0, 0 };
+
+	glGenBuffers(1, &commandBuffer);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(command), &command, GL_DYNAMIC_COPY);
+
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void GPUCuller::Cull(GLfloat scroll) {
+	if (instanceCount == 0)
+		return;
+
+	// Resets the instance count, which the compute shader increments for each visible sprite
+	GLuint zero = 0;
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, offsetof(DrawElementsIndirectCommand, instanceCount), sizeof(GLuint), &zero);
+
+	cullShader -> Use();
+	glUniform1f(glGetUniformLocation(cullShader -> Program, "scroll"), scroll);
+	glUniform1ui(glGetUniformLocation(cullShader -> Program, "instanceTotal"), instanceCount);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, commandBuffer);
+
+	glDispatchCompute((instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+	// Compacted instances are read by the vertex shader, the command by the indirect draw
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+}
+
+void GPUCuller::Draw(GLfloat scroll, GLfloat depth) {
+	if (instanceCount == 0)
+		return;
+
+	drawShader -> Use();
+	glUniform1f(glGetUniformLocation(drawShader -> Program, "scroll"), scroll);
+	glUniform1f(glGetUniformLocation(drawShader -> Program, "depth"), depth);
+
+	GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
+	glUniform1i(glGetUniformLocation(drawShader -> Program, "sprite"), 0);
+
+	GLState::BindVertexArray(VAO);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+GLuint GPUCuller::VisibleCount() {
+	if (instanceCount == 0)
+		return 0;
+
+	// The count was written by the compute shader, not through the buffer API
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+	DrawElementsIndirectCommand command;
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+	glGetBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(command), &command);
+	GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	return command.instanceCount;
+}
+
+GLuint GPUCuller::InstanceCount() {
+	return instanceCount;
+}
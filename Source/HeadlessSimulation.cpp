@@ -0,0 +1,132 @@
+#include <Classes/HeadlessSimulation.h>
+#include <Classes/RewindBuffer.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <random>
+
+// Steps a bot keeps doing the same thing for, at most
+static const int BOT_HOLD = 120;
+
+HeadlessSimulation::HeadlessSimulation() {
+	replayed = false;
+	seconds = 0.0;
+}
+
+void HeadlessSimulation::Run(int sessions, unsigned long long steps, string replay, unsigned int seed, JobSystem *jobs) {
+	this -> sessions.assign(std::max(sessions, 0), Session());
+	replayed = !replay.empty();
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// One session per job, a session's steps depend on each other
+	jobs -> ParallelFor(this -> sessions.size(), 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			if (!replayed) {
+				Play(this -> sessions[i], steps, seed + i);
+				continue;
+			}
+
+			// Sessions don't share their reading position
+			InputRecording recording;
+
+			if (recording.Open(replay))
+				Replay(this -> sessions[i], recording);
+		}
+	});
+
+	seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HeadlessSimulation::Play(Session &session, unsigned long long steps, unsigned int seed) {
+	Simulation simulation;
+	session.deaths = 0;
+
+	// Walks left, right or stands still for a random number of steps, then picks again
+	std::mt19937 random(seed);
+	std::uniform_int_distribution<int> action(0, 2), hold(1, BOT_HOLD);
+	int keys[] = {-1, GLFW_KEY_LEFT, GLFW_KEY_RIGHT};
+	int key = -1, remaining = 0;
+
+	for (session.steps = 0; session.steps < steps; session.steps++) {
+		if (--remaining <= 0) {
+			simulation.Input(key, GLFW_RELEASE);
+			key = keys[action(random)];
+			simulation.Input(key, GLFW_PRESS);
+			remaining = hold(random);
+		}
+
+		if (!simulation.Step()) {
+			simulation.Reset();
+			session.deaths++;
+		}
+	}
+
+	session.state = simulation.State();
+}
+
+void HeadlessSimulation::Replay(Session &session, InputRecording &recording) {
+	Simulation simulation;
+	session.deaths = 0;
+
+	// With rewind recorded, Backspace goes back through a history as large as the session's (see SceneManager::DoMovement)
+	const InputRecording::Options &options = recording.RecordedOptions();
+	RewindBuffer history;
+	Simulation::Checkpoint checkpoint;
+
+	if (options.rewind)
+		history.Create(options.rewindMemory, options.rewindSteps);
+
+	// Same order as SceneManager::Simulate, events of a step come before it
+	for (session.steps = 0; !recording.Finished(session.steps); session.steps++) {
+		int key, action;
+
+		while (recording.Next(session.steps, key, action))
+			simulation.Input(key, action);
+
+		if (options.rewind && (simulation.Held(GLFW_KEY_BACKSPACE) || simulation.Tapped(GLFW_KEY_BACKSPACE))) {
+			if (history.Pop(checkpoint))
+				simulation.Load(checkpoint, false);
+
+			simulation.Pause();
+			continue;
+		}
+
+		if (options.rewind) {
+			simulation.Save(checkpoint);
+			history.Push(checkpoint);
+		}
+
+		// Either respawn goes back to the starting state, so instantRespawn replays alike
+		if (!simulation.Step()) {
+			simulation.Reset();
+			session.deaths++;
+		}
+	}
+
+	session.state = simulation.State();
+}
+
+void HeadlessSimulation::Report() {
+	unsigned long long steps = 0, deaths = 0;
+
+	for (const Session &session : sessions) {
+		steps += session.steps;
+		deaths += session.deaths;
+	}
+
+	double rate = steps / std::max(seconds, 1e-9);
+
+	std::cout << "Headless: " << sessions.size() << (replayed ? " replays, " : " bot sessions, ")
+		<< steps << " steps in " << seconds << " s, " << rate << " steps/s, " << deaths << " deaths" << std::endl;
+
+	// Replays of the same recording all end alike, the first one stands for them
+	if (replayed && !sessions.empty())
+		std::cout << "Replay ended after " << sessions[0].steps << " steps, character at " << sessions[0].state.characterPosition
+			<< ", foreground at " << sessions[0].state.foregroundPosition << std::endl;
+}
+
+const vector<HeadlessSimulation::Session> &HeadlessSimulation::Sessions() {
+	return sessions;
+}
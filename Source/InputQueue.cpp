@@ -0,0 +1,37 @@
+#include <Classes/InputQueue.h>
+
+InputQueue::InputQueue() : head(0), tail(0), dropped(0) {}
+
+bool InputQueue::Push(const InputEvent &event) {
+	size_t write = tail.load(std::memory_order_relaxed);
+
+	// Indices only grow, their difference is the number of queued events
+	if (write - head.load(std::memory_order_acquire) >= CAPACITY) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	events[write & (CAPACITY - 1)] = event;
+	tail.store(write + 1, std::memory_order_release);
+
+	return true;
+}
+
+bool InputQueue::Peek(InputEvent &event) {
+	size_t read = head.load(std::memory_order_relaxed);
+
+	if (read == tail.load(std::memory_order_acquire))
+		return false;
+
+	event = events[read & (CAPACITY - 1)];
+	return true;
+}
+
+void InputQueue::Pop() {
+	// Releases the slot to the producer only once it has been read
+	head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+unsigned int InputQueue::Dropped() {
+	return dropped.load(std::memory_order_relaxed);
+}
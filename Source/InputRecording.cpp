@@ -0,0 +1,194 @@
+#include <Classes/InputRecording.h>
+#include <iostream>
+#include <iterator>
+#include <cstring>
+
+static const char MAGIC[4] = {'T', 'G', 'A', 'I'};
+static const unsigned char VERSION = 2;
+static const size_t HEADER_SIZE = 4 + 1 + 4 + 8 + 1 + 4 + 4;
+
+// Bits of the options byte
+static const unsigned char OPTION_REWIND = 1 << 0, OPTION_INSTANT_RESPAWN = 1 << 1;
+
+static void WriteLittleEndian(unsigned char *bytes, unsigned long long value, int size) {
+	for (int i = 0; i < size; i++)
+		bytes[i] = (value >> (8 * i)) & 0xFF;
+}
+
+static unsigned long long ReadLittleEndian(const unsigned char *bytes, int size) {
+	unsigned long long value = 0;
+
+	for (int i = 0; i < size; i++)
+		value |= (unsigned long long)bytes[i] << (8 * i);
+
+	return value;
+}
+
+InputRecording::InputRecording() {
+	lastStep = 0;
+	position = 0;
+	nextStep = 0;
+	nextKey = 0;
+	nextAction = END;
+	seed = 0;
+	step = 0.0;
+	options.rewind = options.instantRespawn = false;
+	options.rewindMemory = options.rewindSteps = 0;
+}
+
+InputRecording::~InputRecording() {
+	if (output.is_open())
+		Close(lastStep);
+}
+
+bool InputRecording::Create(string filename, unsigned int seed, double step, const Options &options) {
+	output.open(filename.c_str(), ios::binary | ios::trunc);
+
+	if (!output) {
+		std::cout << "Failed to create input recording " << filename << std::endl;
+		return false;
+	}
+
+	this -> seed = seed;
+	this -> step = step;
+	this -> options = options;
+	lastStep = 0;
+
+	unsigned char header[HEADER_SIZE];
+	memcpy(header, MAGIC, 4);
+	header[4] = VERSION;
+
+	WriteLittleEndian(header + 5, seed, 4);
+
+	unsigned long long bits;
+	memcpy(&bits, &step, sizeof(bits));
+	WriteLittleEndian(header + 9, bits, 8);
+
+	header[17] = (options.rewind ? OPTION_REWIND : 0) | (options.instantRespawn ? OPTION_INSTANT_RESPAWN : 0);
+	WriteLittleEndian(header + 18, options.rewindMemory, 4);
+	WriteLittleEndian(header + 22, options.rewindSteps, 4);
+
+	output.write((const char*)header, sizeof(header));
+
+	return true;
+}
+
+void InputRecording::Record(unsigned long long step, int key, int action) {
+	if (!output.is_open())
+		return;
+
+	WriteVarint(step - lastStep);
+	WriteVarint(key);
+	output.put((char)action);
+
+	lastStep = step;
+}
+
+void InputRecording::Close(unsigned long long step) {
+	if (!output.is_open())
+		return;
+
+	WriteVarint(step - lastStep);
+	WriteVarint(0);
+	output.put((char)END);
+
+	output.close();
+}
+
+bool InputRecording::Open(string filename) {
+	ifstream file(filename.c_str(), ios::binary);
+
+	if (!file) {
+		std::cout << "Failed to open input recording " << filename << std::endl;
+		return false;
+	}
+
+	data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+
+	if (data.size() < HEADER_SIZE || memcmp(data.data(), MAGIC, 4) != 0 || data[4] != VERSION) {
+		std::cout << "Invalid input recording " << filename << std::endl;
+		data.clear();
+		return false;
+	}
+
+	seed = ReadLittleEndian(data.data() + 5, 4);
+
+	unsigned long long bits = ReadLittleEndian(data.data() + 9, 8);
+	memcpy(&step, &bits, sizeof(step));
+
+	options.rewind = data[17] & OPTION_REWIND;
+	options.instantRespawn = data[17] & OPTION_INSTANT_RESPAWN;
+	options.rewindMemory = ReadLittleEndian(data.data() + 18, 4);
+	options.rewindSteps = ReadLittleEndian(data.data() + 22, 4);
+
+	position = HEADER_SIZE;
+	nextStep = 0;
+	Advance();
+
+	return true;
+}
+
+unsigned int InputRecording::Seed() {
+	return seed;
+}
+
+double InputRecording::Step() {
+	return step;
+}
+
+const InputRecording::Options &InputRecording::RecordedOptions() {
+	return options;
+}
+
+bool InputRecording::Next(unsigned long long step, int &key, int &action) {
+	if (nextAction == END || nextStep != step)
+		return false;
+
+	key = nextKey;
+	action = nextAction;
+	Advance();
+
+	return true;
+}
+
+bool InputRecording::Finished(unsigned long long step) {
+	return nextAction == END && step >= nextStep;
+}
+
+void InputRecording::WriteVarint(unsigned long long value) {
+	// 7 bits per byte, the high bit set on all but the last one
+	do {
+		unsigned char byte = value & 0x7F;
+		value >>= 7;
+
+		output.put((char)(value ? byte | 0x80 : byte));
+	} while (value);
+}
+
+bool InputRecording::ReadVarint(unsigned long long &value) {
+	value = 0;
+
+	for (int shift = 0; position < data.size() && shift < 64; shift += 7) {
+		unsigned char byte = data[position++];
+		value |= (unsigned long long)(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+void InputRecording::Advance() {
+	unsigned long long delta, key;
+
+	// A truncated file ends where its last complete event does
+	if (!ReadVarint(delta) || !ReadVarint(key) || position >= data.size()) {
+		nextAction = END;
+		return;
+	}
+
+	nextStep += delta;
+	nextKey = (int)key;
+	nextAction = data[position++];
+}
@@ -0,0 +1,242 @@
+#include <Classes/JobSystem.h>
+#include <algorithm>
+
+// Index of the calling thread's worker in its pool, -1 outside of any
+static thread_local int currentWorker = -1;
+static thread_local JobSystem *currentPool = NULL;
+
+JobSystem::Counter::Counter() : count(0) {}
+
+int JobSystem::Counter::Value() {
+	return count.load(memory_order_acquire);
+}
+
+JobSystem::JobSystem() : queued(0), running(false), nextWorker(0) {}
+
+JobSystem::~JobSystem() {
+	Stop();
+}
+
+void JobSystem::Start(int workers) {
+	if (running)
+		return;
+
+	if (workers <= 0)
+		workers = std::max((int)thread::hardware_concurrency() - 1, 1);
+
+	running = true;
+
+	for (int i = 0; i < workers; i++)
+		this -> workers.push_back(new Worker());
+
+	for (int i = 0; i < workers; i++)
+		threads.push_back(thread(&JobSystem::Work, this, i));
+}
+
+void JobSystem::Stop() {
+	{
+		lock_guard<mutex> guard(sleepLock);
+		running = false;
+	}
+	wake.notify_all();
+
+	for (thread &worker : threads)
+		worker.join();
+	threads.clear();
+
+	// Jobs still queued (and those they release) run here, so their counters reach zero and no Wait is left hanging
+	Entry entry;
+
+	while (Steal(-1, entry))
+		Run(entry);
+
+	for (Worker *worker : workers)
+		delete worker;
+	workers.clear();
+
+	queued = 0;
+}
+
+int JobSystem::Workers() {
+	return workers.size();
+}
+
+void JobSystem::Schedule(Job job, Counter *counter) {
+	if (counter)
+		counter -> count.fetch_add(1, memory_order_relaxed);
+
+	Entry entry;
+	entry.job = job;
+	entry.counter = counter;
+
+	Push(entry);
+}
+
+void JobSystem::ScheduleAfter(Counter &dependency, Job job, Counter *counter) {
+	if (counter)
+		counter -> count.fetch_add(1, memory_order_relaxed);
+
+	{
+		// Under the lock, the dependency either hasn't released its waiting jobs yet, or is done
+		lock_guard<mutex> guard(dependency.lock);
+
+		if (dependency.count.load(memory_order_acquire) > 0) {
+			Counter::Continuation continuation;
+			continuation.job = job;
+			continuation.counter = counter;
+
+			dependency.waiting.push_back(continuation);
+			return;
+		}
+	}
+
+	Entry entry;
+	entry.job = job;
+	entry.counter = counter;
+
+	Push(entry);
+}
+
+void JobSystem::Wait(Counter &counter) {
+	int worker = currentPool == this ? currentWorker : -1;
+
+	while (counter.Value() > 0) {
+		Entry entry;
+
+		if ((worker >= 0 && Pop(worker, entry)) || Steal(worker, entry))
+			Run(entry);
+		else
+			this_thread::yield();
+	}
+
+	// The last job may still be releasing the counter's waiting jobs
+	lock_guard<mutex> guard(counter.lock);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grain, function<void(size_t begin, size_t end)> function) {
+	grain = std::max(grain, (size_t)1);
+
+	// A single range, or no workers, runs right here
+	if (count <= grain || workers.empty()) {
+		if (count)
+			function(0, count);
+		return;
+	}
+
+	Counter counter;
+
+	// The first range is left for the calling thread, which would otherwise just wait
+	for (size_t begin = grain; begin < count; begin += grain) {
+		size_t end = std::min(begin + grain, count);
+		Schedule([function, begin, end] { function(begin, end); }, &counter);
+	}
+
+	function(0, grain);
+	Wait(counter);
+}
+
+void JobSystem::Push(const Entry &entry) {
+	// Without workers, jobs run as they are scheduled
+	if (workers.empty()) {
+		Entry immediate = entry;
+		Run(immediate);
+		return;
+	}
+
+	int worker = currentPool == this ? currentWorker : nextWorker++ % workers.size();
+
+	{
+		lock_guard<mutex> guard(workers[worker] -> lock);
+		workers[worker] -> jobs.push_back(entry);
+	}
+
+	queued++;
+
+	{
+		lock_guard<mutex> guard(sleepLock);
+	}
+	wake.notify_one();
+}
+
+bool JobSystem::Pop(int worker, Entry &entry) {
+	lock_guard<mutex> guard(workers[worker] -> lock);
+
+	if (workers[worker] -> jobs.empty())
+		return false;
+
+	entry = workers[worker] -> jobs.back();
+	workers[worker] -> jobs.pop_back();
+	queued--;
+
+	return true;
+}
+
+bool JobSystem::Steal(int thief, Entry &entry) {
+	int count = workers.size();
+
+	// Victims are tried starting after the thief, so workers don't all pick on the same one
+	for (int i = 1; i <= count; i++) {
+		int victim = (std::max(thief, 0) + i) % count;
+
+		if (victim == thief)
+			continue;
+
+		lock_guard<mutex> guard(workers[victim] -> lock);
+
+		if (workers[victim] -> jobs.empty())
+			continue;
+
+		entry = workers[victim] -> jobs.front();
+		workers[victim] -> jobs.pop_front();
+		queued--;
+
+		return true;
+	}
+
+	return false;
+}
+
+void JobSystem::Run(Entry &entry) {
+	entry.job();
+
+	Counter *counter = entry.counter;
+
+	if (!counter)
+		return;
+
+	vector<Counter::Continuation> released;
+
+	{
+		// Under the lock, so Wait can't return (and the counter go away) while it is still in use here
+		lock_guard<mutex> guard(counter -> lock);
+
+		// Last job of the group, its waiting jobs can start
+		if (counter -> count.fetch_sub(1, memory_order_acq_rel) == 1)
+			released.swap(counter -> waiting);
+	}
+
+	for (Counter::Continuation &continuation : released) {
+		Entry next;
+		next.job = continuation.job;
+		next.counter = continuation.counter;
+
+		Push(next);
+	}
+}
+
+void JobSystem::Work(int worker) {
+	currentWorker = worker;
+	currentPool = this;
+
+	while (running) {
+		Entry entry;
+
+		if (Pop(worker, entry) || Steal(worker, entry)) {
+			Run(entry);
+			continue;
+		}
+
+		unique_lock<mutex> guard(sleepLock);
+		wake.wait(guard, [this] { return !running || queued > 0; });
+	}
+}
@@ -0,0 +1,86 @@
+#include <Classes/LayerTarget.h>
+#include <algorithm>
+#include <cmath>
+
+LayerTarget::LayerTarget() {
+	scale = 1.0f;
+	framebuffer = 0;
+	texture = 0;
+	VAO = 0;
+	width = height = 1;
+	shader = NULL;
+}
+
+void LayerTarget::Create(GLfloat scale, GLuint width, GLuint height) {
+	this -> scale = std::max(scale, 0.05f);
+
+	if (!Enabled())
+		return;
+
+	shader = new Shader("Shaders/Composite.vs", "Shaders/Composite.frag");
+
+	// Core profiles need a VAO bound to draw, even without attributes
+	glGenVertexArrays(1, &VAO);
+	glGenFramebuffers(1, &framebuffer);
+	glGenTextures(1, &texture);
+
+	Resize(width, height);
+}
+
+void LayerTarget::Resize(GLuint width, GLuint height) {
+	if (!Enabled())
+		return;
+
+	this -> width = std::max((GLsizei)ceil(width * scale), 1);
+	this -> height = std::max((GLsizei)ceil(height * scale), 1);
+
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	// Upscaled with bilinear filtering, no mipmaps
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, this -> width, this -> height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "Layer target framebuffer is incomplete" << std::endl;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+bool LayerTarget::Enabled() {
+	return scale < 1.0f;
+}
+
+void LayerTarget::Begin() {
+	// Without a depth buffer, the render queue's depth test always passes
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void LayerTarget::End(GLuint width, GLuint height) {
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, width, height);
+}
+
+void LayerTarget::Composite(GLfloat depth) {
+	shader -> Use();
+	glUniform1f(glGetUniformLocation(shader -> Program, "depth"), depth);
+
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
+	GLState::BindVertexArray(VAO);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
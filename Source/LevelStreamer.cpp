@@ -0,0 +1,473 @@
+#include <Classes/LevelStreamer.h>
+#include <Classes/STB_Image.h>
+#include <Classes/GLState.h>
+#include <Classes/ImageAlpha.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+LevelStreamer::LevelStreamer() {
+	tilemap = NULL;
+	lookahead = 0.0f;
+	segmentWidth = 1.0f;
+	memoryCap = 0;
+	memoryUsage = 0;
+	maxLoads = 1;
+	jobs = NULL;
+	running = false;
+}
+
+LevelStreamer::~LevelStreamer() {
+	Stop();
+}
+
+bool LevelStreamer::Start(string directory, Tilemap *tilemap, GLfloat lookahead, size_t memoryCap, JobSystem *jobs, int maxLoads) {
+	Stop();
+
+	// GL objects of a previous run died with its context, so they are dropped without being deleted
+	segments.clear();
+	textures.clear();
+	textureSlots.clear();
+	decodedTextures.clear();
+	memoryUsage = 0;
+
+	this -> directory = directory;
+	this -> tilemap = tilemap;
+	this -> lookahead = lookahead;
+	this -> memoryCap = memoryCap;
+	this -> jobs = jobs;
+	this -> maxLoads = std::max(maxLoads, 1);
+
+	std::ifstream file((directory + "/level.txt").c_str());
+
+	if (!file) {
+		std::cout << "Failed to load level " << directory << std::endl;
+		return false;
+	}
+
+	string tileset;
+	int columns, rows;
+	GLfloat tileSize;
+
+	file >> tileset >> columns >> rows >> tileSize >> origin.x >> origin.y;
+
+	tilemap -> LoadTileset(tileset, columns, rows);
+	tilemap -> SetTileSize(tileSize);
+	tilemap -> SetOrigin(origin);
+
+	segmentWidth = Tilemap::CHUNK_SIZE * tileSize;
+
+	running = true;
+
+	return true;
+}
+
+void LevelStreamer::Stop() {
+	running = false;
+
+	// Loads already started finish, or skip their work once they see the streamer stopped
+	if (jobs)
+		jobs -> Wait(loads);
+
+	requested.clear();
+
+	for (LoadedSegment &loaded : finished)
+		for (Image &image : loaded.images)
+			stbi_image_free(image.data);
+	finished.clear();
+
+	for (Image &image : uploads)
+		stbi_image_free(image.data);
+	uploads.clear();
+
+	for (auto &pending : pendingImages) {
+		stbi_image_free(pending.second.data);
+
+		lock_guard<mutex> guard(lock);
+		decodedTextures.erase(pending.first);
+	}
+	pendingImages.clear();
+}
+
+void LevelStreamer::Update(GLfloat cameraX) {
+	if (!running)
+		return;
+
+	// Finished segments are picked up only if the jobs aren't holding the lock
+	vector<LoadedSegment> ready;
+
+	if (lock.try_lock()) {
+		ready.swap(finished);
+		lock.unlock();
+	}
+
+	for (LoadedSegment &loaded : ready)
+		Integrate(loaded);
+
+	// Uploads are spread across frames, one texture each
+	if (!uploads.empty()) {
+		UploadTexture(uploads.front());
+		uploads.pop_front();
+	}
+
+	int current = SegmentAt(cameraX);
+	int first = std::max(SegmentAt(cameraX - lookahead), 0);
+	int last = SegmentAt(cameraX + lookahead);
+
+	// Segments out of reach are evicted, with one segment of slack so turning back doesn't reload them
+	vector<int> evicted;
+
+	for (auto &segment : segments)
+		if (segment.first < first - 1 || segment.first > last + 1)
+			evicted.push_back(segment.first);
+
+	// Over the memory cap, the farthest segments go first
+	size_t usage = memoryUsage;
+	vector<int> loaded;
+
+	for (auto &segment : segments)
+		if (segment.second.loaded && std::find(evicted.begin(), evicted.end(), segment.first) == evicted.end())
+			loaded.push_back(segment.first);
+
+	std::sort(loaded.begin(), loaded.end(), [current](int a, int b) {
+		return std::abs(a - current) > std::abs(b - current);
+	});
+
+	for (int index : loaded) {
+		if (usage <= memoryCap || index == current)
+			break;
+
+		usage -= segments[index].bytes;
+		evicted.push_back(index);
+	}
+
+	for (int index : evicted)
+		Evict(index);
+
+	// Missing segments are requested nearest first, while the expected usage fits in the cap
+	vector<int> requests;
+
+	for (int index = first; index <= last; index++)
+		if (segments.find(index) == segments.end())
+			requests.push_back(index);
+
+	std::sort(requests.begin(), requests.end(), [current](int a, int b) {
+		return std::abs(a - current) < std::abs(b - current);
+	});
+
+	unsigned int loadedCount = 0, pendingCount = 0;
+	for (auto &segment : segments)
+		if (segment.second.loaded)
+			loadedCount++;
+		else
+			pendingCount++;
+
+	size_t averageBytes = loadedCount ? memoryUsage / loadedCount : 0;
+	size_t expected = memoryUsage + pendingCount * averageBytes;
+
+	vector<int> scheduled;
+
+	for (int index : requests) {
+		if (expected + averageBytes > memoryCap && index != current)
+			break;
+
+		Segment segment;
+		segment.loaded = false;
+		segment.bytes = 0;
+		segments[index] = segment;
+
+		scheduled.push_back(index);
+		expected += averageBytes;
+	}
+
+	requested.insert(requested.end(), scheduled.begin(), scheduled.end());
+
+	// Jobs are only handed a few segments at a time, so loads don't crowd out the pool's other work
+	while (!requested.empty() && loads.Value() < maxLoads) {
+		int index = requested.front();
+		requested.pop_front();
+
+		jobs -> Schedule([this, index] { Load(index); }, &loads);
+	}
+}
+
+void LevelStreamer::VisibleSprites(const AABB &view, vector<const Sprite*> &result) {
+	// Sprites may overhang their segment, so the neighbours are checked too
+	int first = SegmentAt(view.min.x) - 1, last = SegmentAt(view.max.x) + 1;
+
+	for (int index = first; index <= last; index++) {
+		auto segment = segments.find(index);
+		if (segment == segments.end() || !segment -> second.loaded)
+			continue;
+
+		for (const Sprite &sprite : segment -> second.sprites) {
+			if (!textures[sprite.textureSlot].texture)
+				continue;
+
+			AABB bounds(
+				glm::vec2(sprite.position.x - 0.5f * sprite.size.x, sprite.position.y),
+				glm::vec2(sprite.position.x + 0.5f * sprite.size.x, sprite.position.y + sprite.size.y)
+			);
+
+			if (bounds.Intersects(view))
+				result.push_back(&sprite);
+		}
+	}
+}
+
+GLuint LevelStreamer::Texture(GLuint slot) {
+	return textures[slot].texture;
+}
+
+bool LevelStreamer::TextureOpaque(GLuint slot) {
+	return textures[slot].opaque;
+}
+
+unsigned int LevelStreamer::LoadedSegments() {
+	unsigned int count = 0;
+
+	for (auto &segment : segments)
+		if (segment.second.loaded)
+			count++;
+
+	return count;
+}
+
+unsigned int LevelStreamer::PendingSegments() {
+	return segments.size() - LoadedSegments();
+}
+
+bool LevelStreamer::Busy() {
+	return PendingSegments() > 0 || !uploads.empty();
+}
+
+size_t LevelStreamer::MemoryUsage() {
+	return memoryUsage;
+}
+
+void LevelStreamer::Load(int index) {
+	if (!running)
+		return;
+
+	LoadedSegment result;
+	LoadSegment(index, result);
+
+	lock_guard<mutex> guard(lock);
+	finished.push_back(result);
+}
+
+void LevelStreamer::LoadSegment(int index, LoadedSegment &result) {
+	result.index = index;
+
+	std::stringstream filename;
+	filename << directory << "/" << index << ".segment";
+
+	// Missing segments are past the end of the level, and simply stay empty
+	std::ifstream file(filename.str().c_str());
+	if (!file)
+		return;
+
+	string line;
+
+	while (std::getline(file, line)) {
+		if (line.compare(0, 7, "sprite ") != 0) {
+			if (!line.empty())
+				result.tileRows.push_back(line);
+			continue;
+		}
+
+		std::stringstream spriteStream(line.substr(7));
+		string texture;
+		Sprite sprite;
+
+		spriteStream >> texture >> sprite.position.x >> sprite.position.y >> sprite.size.x >> sprite.size.y;
+
+		// Texture slots are resolved by the main thread, this indexes spriteTextures meanwhile
+		auto known = std::find(result.spriteTextures.begin(), result.spriteTextures.end(), texture);
+		sprite.textureSlot = known - result.spriteTextures.begin();
+
+		if (known == result.spriteTextures.end())
+			result.spriteTextures.push_back(texture);
+
+		result.sprites.push_back(sprite);
+	}
+
+	// Each texture is decoded by a single job, until it gets evicted
+	for (const string &path : result.spriteTextures) {
+		{
+			lock_guard<mutex> guard(lock);
+			if (!decodedTextures.insert(path).second)
+				continue;
+		}
+
+		Image image;
+		image.path = path;
+		image.data = stbi_load(path.c_str(), &image.width, &image.height, &image.channels, 0);
+		image.opaque = ImageAlpha::Opaque(image.data, image.width, image.height, image.channels);
+
+		if (image.data)
+			result.images.push_back(image);
+		else
+			std::cout << "Failed to load streamed texture " << path << std::endl;
+	}
+}
+
+void LevelStreamer::Integrate(LoadedSegment &loaded) {
+	auto segment = segments.find(loaded.index);
+
+	// Evicted (or already loaded by a duplicate request) while its job was running
+	if (segment == segments.end() || segment -> second.loaded) {
+		for (Image &image : loaded.images) {
+			if (textureSlots.count(image.path))
+				uploads.push_back(image);
+			else if (!pendingImages.insert(std::make_pair(image.path, image)).second)
+				stbi_image_free(image.data);
+		}
+		return;
+	}
+
+	for (int row = 0; row < (int)loaded.tileRows.size(); row++) {
+		int y = loaded.tileRows.size() - 1 - row;
+
+		// Segments are a single chunk high
+		if (y >= Tilemap::CHUNK_SIZE)
+			continue;
+
+		for (int x = 0; x < (int)loaded.tileRows[row].size() && x < Tilemap::CHUNK_SIZE; x++)
+			tilemap -> SetTile(loaded.index * Tilemap::CHUNK_SIZE + x, y, Tilemap::TileIndex(loaded.tileRows[row][x]));
+	}
+
+	glm::vec2 corner(origin.x + loaded.index * segmentWidth, origin.y);
+	vector<Sprite> &sprites = segment -> second.sprites;
+
+	for (Sprite sprite : loaded.sprites) {
+		sprite.textureSlot = AcquireTexture(loaded.spriteTextures[sprite.textureSlot]);
+		sprite.position += corner;
+		sprites.push_back(sprite);
+	}
+
+	uploads.insert(uploads.end(), loaded.images.begin(), loaded.images.end());
+
+	for (const string &path : loaded.spriteTextures) {
+		auto pending = pendingImages.find(path);
+		if (pending == pendingImages.end())
+			continue;
+
+		uploads.push_back(pending -> second);
+		pendingImages.erase(pending);
+	}
+
+	segment -> second.loaded = true;
+	segment -> second.bytes = Tilemap::CHUNK_SIZE * Tilemap::CHUNK_SIZE * sizeof(short) + sprites.size() * sizeof(Sprite);
+	memoryUsage += segment -> second.bytes;
+}
+
+void LevelStreamer::Evict(int index) {
+	auto segment = segments.find(index);
+	if (segment == segments.end())
+		return;
+
+	if (segment -> second.loaded) {
+		tilemap -> RemoveChunk(index, 0);
+
+		for (const Sprite &sprite : segment -> second.sprites)
+			ReleaseTexture(sprite.textureSlot);
+
+		memoryUsage -= segment -> second.bytes;
+	} else
+		requested.erase(std::remove(requested.begin(), requested.end(), index), requested.end());
+
+	segments.erase(segment);
+}
+
+void LevelStreamer::UploadTexture(Image &image) {
+	auto slot = textureSlots.find(image.path);
+
+	// Released before its turn, or decoded twice
+	if (slot == textureSlots.end() || textures[slot -> second].texture) {
+		stbi_image_free(image.data);
+		return;
+	}
+
+	TextureSlot &texture = textures[slot -> second];
+
+	glGenTextures(1, &texture.texture);
+	GLState::BindTexture(GL_TEXTURE_2D, texture.texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	GLenum format = image.channels == 4 ? GL_RGBA : GL_RGB;
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+	stbi_image_free(image.data);
+
+	texture.opaque = image.opaque;
+	texture.bytes = image.width * image.height * 4;
+	memoryUsage += texture.bytes;
+}
+
+GLuint LevelStreamer::AcquireTexture(string path) {
+	auto slot = textureSlots.find(path);
+
+	if (slot == textureSlots.end()) {
+		TextureSlot texture;
+		texture.path = path;
+		texture.texture = 0;
+		texture.opaque = false;
+		texture.references = 0;
+		texture.bytes = 0;
+
+		// Reuses the slot of a released texture when there is one
+		GLuint index = 0;
+		while (index < textures.size() && !textures[index].path.empty())
+			index++;
+
+		if (index == textures.size())
+			textures.push_back(texture);
+		else
+			textures[index] = texture;
+
+		slot = textureSlots.insert(std::make_pair(path, index)).first;
+	}
+
+	textures[slot -> second].references++;
+
+	return slot -> second;
+}
+
+void LevelStreamer::ReleaseTexture(GLuint slot) {
+	TextureSlot &texture = textures[slot];
+
+	if (--texture.references > 0)
+		return;
+
+	if (texture.texture)
+		GLState::DeleteTextures(1, &texture.texture);
+
+	memoryUsage -= texture.bytes;
+	textureSlots.erase(texture.path);
+
+	{
+		lock_guard<mutex> guard(lock);
+		decodedTextures.erase(texture.path);
+	}
+
+	texture.path.clear();
+	texture.texture = 0;
+	texture.opaque = false;
+	texture.bytes = 0;
+}
+
+int LevelStreamer::SegmentAt(GLfloat x) {
+	return (int)std::floor((x - origin.x) / segmentWidth);
+}
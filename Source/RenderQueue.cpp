@@ -0,0 +1,259 @@
+#include <Classes/RenderQueue.h>
+#include <Classes/GLState.h>
+#include <GLM/gtc/matrix_transform.hpp>
+#include <GLM/gtc/type_ptr.hpp>
+#include <algorithm>
+
+static const GLuint64 OPAQUE_DEPTH_MAX = (1ull << 31) - 1;
+static const GLuint64 BLENDED_DEPTH_MAX = (1ull << 29) - 1;
+
+GLuint64 RenderQueue::Key(GLuint layer, Blend blend, GLuint program, GLuint texture, GLfloat depth) {
+	depth = glm::clamp(depth, 0.0f, 1.0f);
+	GLuint64 state = ((GLuint64)(program & 0xFF) << 16) | (texture & 0xFFFF);
+
+	// Opaque packets are grouped by state, nearest layers first
+	if (blend == BLEND_NONE)
+		return ((GLuint64)(0xFF - (layer & 0xFF)) << 55) | (state << 31) | (GLuint64)(depth * OPAQUE_DEPTH_MAX);
+
+	// Blended ones must be drawn back to front first
+	GLuint64 quantized = (GLuint64)(depth * BLENDED_DEPTH_MAX);
+
+	return (1ull << 63) | ((GLuint64)(layer & 0xFF) << 55) | ((GLuint64)blend << 53) | ((BLENDED_DEPTH_MAX - quantized) << 24) | state;
+}
+
+RenderQueue::RenderQueue() {
+	draws = 0;
+	jobs = NULL;
+	parallelSprites = parallelGrain = 0;
+}
+
+void RenderQueue::SetJobs(JobSystem *jobs, GLuint minSprites, GLuint grain) {
+	this -> jobs = jobs;
+	parallelSprites = std::max(minSprites, 1u);
+	parallelGrain = std::max(grain, 1u);
+}
+
+void RenderQueue::Clear() {
+	packets.clear();
+	entries.clear();
+}
+
+void RenderQueue::SubmitMesh(GLuint layer, Blend blend, GLfloat depth, GLuint program, GLuint texture, GLuint VAO, GLsizei indexCount, const AABB &bounds, glm::vec3 translation, glm::vec2 textureOffset) {
+	Packet packet;
+	packet.type = MESH;
+	packet.program = program;
+	packet.texture = texture;
+	packet.VAO = VAO;
+	packet.indexCount = indexCount;
+	packet.bounds = bounds;
+	packet.translation = translation;
+	packet.textureOffset = textureOffset;
+
+	Submit(layer, blend, depth, packet);
+}
+
+void RenderQueue::SubmitSprite(GLuint layer, Blend blend, GLfloat depth, GLuint program, GLuint texture, const AABB &quad, glm::vec2 uvMin, glm::vec2 uvMax, glm::vec3 translation) {
+	Packet packet;
+	packet.type = SPRITE;
+	packet.program = program;
+	packet.texture = texture;
+	packet.bounds = quad;
+	packet.uvMin = uvMin;
+	packet.uvMax = uvMax;
+	packet.translation = translation;
+	packet.textureOffset = glm::vec2(0.0f, 0.0f);
+
+	Submit(layer, blend, depth, packet);
+}
+
+void RenderQueue::SubmitCustom(GLuint layer, Blend blend, GLfloat depth, std::function<void(GLfloat depth)> draw) {
+	Packet packet;
+	packet.type = CUSTOM;
+	packet.program = 0;
+	packet.texture = 0;
+	packet.draw = draw;
+
+	Submit(layer, blend, depth, packet);
+}
+
+void RenderQueue::Submit(GLuint layer, Blend blend, GLfloat depth, Packet &packet) {
+	packet.layer = layer;
+	packet.blend = blend;
+	packet.depth = depth;
+
+	SortEntry entry;
+	entry.key = Key(layer, blend, packet.program, packet.texture, depth);
+	entry.packet = packets.size();
+
+	packets.push_back(packet);
+	entries.push_back(entry);
+}
+
+void RenderQueue::Sort() {
+	scratch.resize(entries.size());
+
+	// Least significant byte first, each pass is a stable counting sort
+	for (int shift = 0; shift < 64; shift += 8) {
+		size_t offsets[256] = {0};
+
+		for (const SortEntry &entry : entries)
+			offsets[(entry.key >> shift) & 0xFF]++;
+
+		// Every key has the same byte here, so the pass wouldn't move anything
+		if (entries.empty() || offsets[(entries[0].key >> shift) & 0xFF] == entries.size())
+			continue;
+
+		size_t start = 0;
+		for (int digit = 0; digit < 256; digit++) {
+			size_t count = offsets[digit];
+			offsets[digit] = start;
+			start += count;
+		}
+
+		for (const SortEntry &entry : entries)
+			scratch[offsets[(entry.key >> shift) & 0xFF]++] = entry;
+
+		entries.swap(scratch);
+	}
+}
+
+void RenderQueue::Latch(GLuint layer, glm::vec3 translation, glm::vec2 textureOffset) {
+	// Custom draws read their state when they run, so they are already up to date
+	for (Packet &packet : packets)
+		if (packet.layer == layer && packet.type != CUSTOM) {
+			packet.translation = packet.translation + translation;
+			packet.textureOffset = packet.textureOffset + textureOffset;
+		}
+}
+
+void RenderQueue::Execute(SpriteBatch &batch) {
+	Sort();
+	draws = 0;
+
+	// Fragments at the depth of an earlier one pass, so packets sharing a depth keep their order
+	GLState::Enable(GL_DEPTH_TEST);
+	GLState::DepthFunc(GL_LEQUAL);
+
+	// Packet the sprites waiting in the batch were added with
+	const Packet *batched = NULL;
+
+	for (size_t i = 0; i < entries.size(); i++) {
+		const Packet &packet = packets[entries[i].packet];
+
+		if (packet.type == SPRITE) {
+			if (!batched || !SameState(*batched, packet)) {
+				if (batched) {
+					batch.Flush();
+					draws++;
+				}
+
+				Apply(packet, batch.Bounds());
+				batched = &packet;
+			}
+
+			// The whole run of sprites sharing this state goes in at once
+			size_t last = i + 1;
+
+			while (last < entries.size() && packets[entries[last].packet].type == SPRITE && SameState(packet, packets[entries[last].packet]))
+				last++;
+
+			AddSprites(batch, i, last);
+			i = last - 1;
+			continue;
+		}
+
+		if (batched) {
+			batch.Flush();
+			draws++;
+			batched = NULL;
+		}
+
+		if (packet.type == MESH) {
+			Apply(packet, packet.bounds);
+			GLState::BindVertexArray(packet.VAO);
+			glDrawElements(GL_TRIANGLES, packet.indexCount, GL_UNSIGNED_INT, 0);
+		} else {
+			SetPass(packet.blend);
+			packet.draw(packet.depth * 2.0f - 1.0f);
+		}
+
+		draws++;
+	}
+
+	if (batched) {
+		batch.Flush();
+		draws++;
+	}
+
+	// Depth writes must be back on for the next frame's clear
+	GLState::DepthMask(GL_TRUE);
+	GLState::Disable(GL_DEPTH_TEST);
+}
+
+void RenderQueue::SetPass(Blend blend) {
+	GLState::DepthMask(blend == BLEND_NONE ? GL_TRUE : GL_FALSE);
+
+	if (blend == BLEND_NONE) {
+		GLState::Disable(GL_BLEND);
+		return;
+	}
+
+	GLState::Enable(GL_BLEND);
+
+	// Alpha accumulates as coverage, so offscreen targets cleared to transparent end up premultiplied (see LayerTarget)
+	if (blend == BLEND_ADDITIVE)
+		GLState::BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
+	else
+		GLState::BlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+}
+
+void RenderQueue::Apply(const Packet &packet, const AABB &bounds) {
+	GLState::UseProgram(packet.program);
+	SetPass(packet.blend);
+
+	glm::mat4 model = glm::translate(glm::mat4(), packet.translation);
+	glUniformMatrix4fv(glGetUniformLocation(packet.program, "model"), 1, GL_FALSE, glm::value_ptr(model));
+
+	glUniform1f(glGetUniformLocation(packet.program, "offsetx"), packet.textureOffset.x);
+	glUniform1f(glGetUniformLocation(packet.program, "offsety"), packet.textureOffset.y);
+	glUniform4f(glGetUniformLocation(packet.program, "bounds"), bounds.min.x, bounds.min.y, bounds.max.x, bounds.max.y);
+	glUniform1f(glGetUniformLocation(packet.program, "depth"), packet.depth * 2.0f - 1.0f);
+
+	GLState::BindTexture(GL_TEXTURE_2D, packet.texture);
+}
+
+bool RenderQueue::SameState(const Packet &a, const Packet &b) {
+	return a.program == b.program
+		&& a.texture == b.texture
+		&& a.blend == b.blend
+		&& a.depth == b.depth
+		&& a.translation == b.translation;
+}
+
+void RenderQueue::AddSprites(SpriteBatch &batch, size_t first, size_t last) {
+	if (!jobs || last - first < parallelSprites) {
+		for (size_t i = first; i < last; i++) {
+			const Packet &packet = packets[entries[i].packet];
+			batch.Add(packet.bounds, packet.uvMin, packet.uvMax);
+		}
+
+		return;
+	}
+
+	// Packets and entries aren't changed while the jobs read them
+	batch.AddParallel(last - first, *jobs, parallelGrain, [this, first](GLuint index, AABB &bounds, glm::vec2 &uvMin, glm::vec2 &uvMax) {
+		const Packet &packet = packets[entries[first + index].packet];
+
+		bounds = packet.bounds;
+		uvMin = packet.uvMin;
+		uvMax = packet.uvMax;
+	});
+}
+
+unsigned int RenderQueue::Packets() {
+	return entries.size();
+}
+
+unsigned int RenderQueue::Draws() {
+	return draws;
+}
@@ -0,0 +1,198 @@
+#include <Classes/RewindBuffer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+static const size_t CHECKPOINT_SIZE = sizeof(Simulation::Checkpoint);
+
+// Base of keyframes, so they are encoded the same way as deltas
+static const unsigned char ZERO[CHECKPOINT_SIZE] = {0};
+
+RewindBuffer::RewindBuffer() {
+	first = count = tail = used = 0;
+	sinceKeyframe = 0;
+	captureTime = 0.0;
+}
+
+void RewindBuffer::Create(size_t memory, size_t steps) {
+	bytes.assign(memory, 0);
+	entries.assign(std::max(steps, (size_t)1), Entry());
+
+	// Worst case, every byte differs: a pair of counts per 255 literals
+	scratch.assign(CHECKPOINT_SIZE + 2 * (CHECKPOINT_SIZE / 255 + 2), 0);
+
+	Clear();
+}
+
+void RewindBuffer::Clear() {
+	first = count = tail = used = 0;
+	sinceKeyframe = 0;
+}
+
+RewindBuffer::Entry &RewindBuffer::At(size_t index) {
+	return entries[(first + index) % entries.size()];
+}
+
+void RewindBuffer::Push(const Simulation::Checkpoint &checkpoint) {
+	if (bytes.empty())
+		return;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const unsigned char *data = (const unsigned char*)&checkpoint;
+
+	if (count == entries.size())
+		Evict();
+
+	bool key = count == 0 || sinceKeyframe >= KEYFRAME_INTERVAL;
+	size_t size = Encode(data, key ? ZERO : (const unsigned char*)&keyframe);
+	size_t offset;
+
+	// Evicting may take the delta's own keyframe, it is then stored as a keyframe itself
+	while (!Fits(size, offset)) {
+		if (count == 0)
+			return;
+
+		Evict();
+
+		if (count == 0 && !key) {
+			key = true;
+			size = Encode(data, ZERO);
+		}
+	}
+
+	memcpy(&bytes[offset], &scratch[0], size);
+	tail = offset + size;
+	used += size;
+
+	Entry &entry = At(count++);
+	entry.offset = offset;
+	entry.size = size;
+	entry.keyframe = key;
+
+	if (key) {
+		keyframe = checkpoint;
+		sinceKeyframe = 0;
+	}
+
+	sinceKeyframe++;
+
+	double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	captureTime = captureTime > 0.0 ? captureTime + (time - captureTime) * 0.1 : time;
+}
+
+bool RewindBuffer::Pop(Simulation::Checkpoint &checkpoint) {
+	if (count == 0)
+		return false;
+
+	Entry entry = At(--count);
+	Decode(entry, entry.keyframe ? ZERO : (const unsigned char*)&keyframe, (unsigned char*)&checkpoint);
+
+	// The newest entry ended the used bytes, so its space is free again
+	tail = entry.offset;
+	used -= entry.size;
+
+	if (!entry.keyframe) {
+		sinceKeyframe--;
+		return true;
+	}
+
+	// Back into the previous keyframe's deltas, which need it decoded
+	sinceKeyframe = 0;
+
+	for (size_t i = count; i > 0; i--)
+		if (At(i - 1).keyframe) {
+			Decode(At(i - 1), ZERO, (unsigned char*)&keyframe);
+			sinceKeyframe = count - (i - 1);
+			break;
+		}
+
+	return true;
+}
+
+size_t RewindBuffer::Encode(const unsigned char *data, const unsigned char *base) {
+	size_t i = 0, size = 0;
+
+	while (i < CHECKPOINT_SIZE) {
+		unsigned char zeros = 0, literals = 0;
+
+		while (i < CHECKPOINT_SIZE && zeros < 255 && data[i] == base[i]) {
+			zeros++;
+			i++;
+		}
+
+		size_t run = size + 2;
+
+		while (i < CHECKPOINT_SIZE && literals < 255 && data[i] != base[i]) {
+			scratch[run + literals] = data[i] ^ base[i];
+			literals++;
+			i++;
+		}
+
+		scratch[size] = zeros;
+		scratch[size + 1] = literals;
+		size = run + literals;
+	}
+
+	return size;
+}
+
+void RewindBuffer::Decode(const Entry &entry, const unsigned char *base, unsigned char *data) {
+	memcpy(data, base, CHECKPOINT_SIZE);
+
+	const unsigned char *encoded = &bytes[entry.offset], *end = encoded + entry.size;
+	size_t i = 0;
+
+	while (encoded < end) {
+		i += encoded[0];
+		unsigned char literals = encoded[1];
+		encoded += 2;
+
+		for (unsigned char j = 0; j < literals; j++)
+			data[i++] ^= *encoded++;
+	}
+}
+
+bool RewindBuffer::Fits(size_t size, size_t &offset) {
+	if (count == 0) {
+		tail = 0;
+		offset = 0;
+		return size <= bytes.size();
+	}
+
+	size_t head = At(0).offset;
+
+	// Gaps are kept strictly larger than the entry, so a full ring never looks empty (tail == head)
+	if (tail >= head) {
+		if (bytes.size() - tail >= size) {
+			offset = tail;
+			return true;
+		}
+
+		// Past the end, the bytes left there stay unused until the ring comes around again
+		offset = 0;
+		return size < head;
+	}
+
+	offset = tail;
+	return head - tail > size;
+}
+
+void RewindBuffer::Evict() {
+	do {
+		used -= At(0).size;
+		first = (first + 1) % entries.size();
+		count--;
+	} while (count > 0 && !At(0).keyframe);
+}
+
+size_t RewindBuffer::States() {
+	return count;
+}
+
+size_t RewindBuffer::Memory() {
+	return used;
+}
+
+double RewindBuffer::CaptureTime() {
+	return captureTime;
+}
@@ -1,33 +1,150 @@
 #include <Classes/SceneManager.h>
+#include <Classes/ImageAlpha.h>
+#include <random>
+#include <algorithm>
+#include <cmath>
 
-static bool keys[1024];
-static bool resized;
+// Filled by KeyCallback, drained by the simulation
+static InputQueue input;
+
+// Steps run per frame at most, beyond that the simulation skips ahead instead of falling further behind
+static const int MAX_STEPS = 5;
+
+// Wall clock time fast replays step for between two frames
+static const double FAST_REPLAY_TIME = 1.0 / 60.0;
+
+static bool resized, damaged;
 static GLuint width, height;
 
+// Clock of input events and simulation steps, which unlike glfwGetTime doesn't start over when a respawn calls glfwInit
+static double Now() {
+	static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Bounds of a quad given by 4 vertices of 8 floats, as laid out in the Setup* functions
+static AABB QuadBounds(const float *vertices) {
+	AABB bounds(glm::vec2(vertices[0], vertices[1]), glm::vec2(vertices[0], vertices[1]));
+
+	for (int i = 1; i < 4; i++) {
+		glm::vec2 position(vertices[i * 8], vertices[i * 8 + 1]);
+		bounds.min = glm::min(bounds.min, position);
+		bounds.max = glm::max(bounds.max, position);
+	}
+
+	return bounds;
+}
+
+// Packs a quad laid out as in the Setup* functions, with positions normalized within bounds
+static void PackQuad(const float *vertices, const AABB &bounds, SpriteVertex *packed) {
+	for (int i = 0; i < 4; i++) {
+		const float *vertex = vertices + i * 8;
+
+		packed[i] = SpriteVertex(
+			glm::vec2(vertex[0], vertex[1]),
+			bounds,
+			glm::vec2(vertex[6], vertex[7]),
+			glm::vec4(vertex[3], vertex[4], vertex[5], 1.0f)
+		);
+	}
+}
+
+// Layers are flat, each one drawn at its own depth, in front of the layers before it
+static GLfloat LayerDepth(SceneLayer layer) {
+	return 1.0f - (layer + 1) / 256.0f;
+}
+
 SceneManager::SceneManager() {}
 
-SceneManager::~SceneManager() {}
+SceneManager::~SceneManager() {
+	jobs.Stop();
+}
 
 void SceneManager::Initialize(GLuint width, GLuint height) {
 	::width = width;
 	::height = height;
 
-	// GLFW - GLEW - OPENGL general setup -- TODO: config file
+	settings.Load("Settings/Settings.json");
+
+	simulationStep = 1.0 / std::max(settings.GetFloat("simulationRate", 60.0f), 1.0f);
+	stepCount = 0;
+	seed = settings.GetInt("randomSeed", 1);
+
+	// Outlives respawns, which only recreate the window and its resources
+	jobs.Start(settings.GetInt("jobWorkers", 0));
+
+	// Headless runs only simulate, there is no window, context or input of their own (see RunHeadless)
+	headless = settings.GetBool("headless", false);
+
+	if (headless)
+		return;
+
+	// A replay brings its own seed, step and options, so the simulation goes through the same states
+	string replayFile = settings.GetString("inputReplay", ""), recordFile = settings.GetString("inputRecord", "");
+
+	replayInput = !replayFile.empty() && recording.Open(replayFile);
+	replayFast = settings.GetString("replaySpeed", "realtime") == "fast";
+	recordInput = !replayInput && !recordFile.empty();
+
+	if (replayInput) {
+		seed = recording.Seed();
+		simulationStep = recording.Step();
+	}
+
+	InputRecording::Options options;
+	options.rewind = settings.GetBool("rewind", false);
+	options.instantRespawn = settings.GetBool("instantRespawn", false);
+	options.rewindMemory = settings.GetFloat("rewindMemory", 16.0f) * 1024 * 1024;
+	options.rewindSteps = settings.GetFloat("rewindSeconds", 10.0f) / simulationStep;
+
+	if (replayInput) {
+		const InputRecording::Options &recorded = recording.RecordedOptions();
+
+		if (recorded.rewind != options.rewind || recorded.instantRespawn != options.instantRespawn
+			|| (recorded.rewind && (recorded.rewindMemory != options.rewindMemory || recorded.rewindSteps != options.rewindSteps)))
+			std::cout << "Replaying with the rewind and instantRespawn settings of " << replayFile << ", not the ones in Settings.json" << std::endl;
+
+		options = recorded;
+	} else if (recordInput)
+		recordInput = recording.Create(recordFile, seed, simulationStep, options);
+
+	// GLFW - GLEW - OPENGL general setup
 	InitializeGraphics();
+
+	// Deaths can go back to the start without rebuilding anything (see Respawn)
+	instantRespawn = options.instantRespawn;
+	simulation.Save(spawn);
+
+	// Allocated once, capped both in time and memory
+	rewind = options.rewind;
+
+	if (rewind)
+		history.Create(options.rewindMemory, options.rewindSteps);
 }
 
 void SceneManager::InitializeGraphics() {
-	backgroundPosition = 0.0;
-	foregroundPosition = 0.0;
-	characterPosition = 0.85;
-	boxPosition = -0.85;
-	verticalPosition = -0.275;
-	offsetX = 0.0;
-	offsetY = 0.0;
+	simulation.Reset();
 
 	glfwInit();
 
+	// GPU culling and vertex pulling need OpenGL 4.3, which some drivers (e.g. Mesa) only expose on core profiles
+	gpuCulling = settings.GetString("spriteCulling", "cpu") == "gpu";
+	pulledSprites = settings.GetString("spriteBatchMode", "vertices") == "pulled";
+	opaquePass = settings.GetBool("opaquePass", true);
+
+	if (gpuCulling || pulledSprites) {
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	}
+
 	window = glfwCreateWindow(width, height, "Game", nullptr, nullptr);
+
+	if (!window && (gpuCulling || pulledSprites)) {
+		glfwDefaultWindowHints();
+		window = glfwCreateWindow(width, height, "Game", nullptr, nullptr);
+	}
+
 	glfwMakeContextCurrent(window);
 
 	// Set the required callback functions
@@ -35,16 +152,72 @@ void SceneManager::InitializeGraphics() {
 
 	glfwSetWindowSizeCallback(window, Resize);
 
+	glfwSetWindowRefreshCallback(window, Refresh);
+
 	// glad: load all OpenGL function pointers
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
 		std::cout << "Failed to initialize GLAD" << std::endl;
 
-	AddShader("Shaders/Shader.vs", "Shaders/Shader.frag");
+	GLExtensions::Load();
+	GLState::Reset();
 
-	SetupScene();
+	if (gpuCulling && !GLExtensions::computeShaders) {
+		std::cout << "OpenGL 4.3 is not available, using CPU culling" << std::endl;
+		gpuCulling = false;
+	}
+
+	if (pulledSprites && !GLExtensions::vertexStorageBuffers) {
+		std::cout << "Vertex shader storage buffers are not available, batching sprite vertices" << std::endl;
+		pulledSprites = false;
+	}
+
+	SetupFramePacing();
+
+	simulationTime = Now();
+	respawn = false;
+
+	lateLatch = settings.GetBool("lateLatch", false);
+	inputEvents = 0;
+	inputTimeSum = oldestInput = 0.0;
+
+	frameUniforms.Create();
+	lastFrameTime = glfwGetTime();
+
+	dynamicResolution = settings.GetBool("dynamicResolution", false);
+
+	if (dynamicResolution) {
+		resolution = DynamicResolution();
+		resolution.Create(
+			::width, ::height,
+			settings.GetFloat("resolutionScaleMin", 0.5f),
+			settings.GetFloat("resolutionScaleMax", 1.0f),
+			settings.GetFloat("gpuFrameTarget", 14.0f)
+		);
+	}
+
+	const char *layerResolutions[PARALLAX_LAYERS] = {"backgroundResolution", "foregroundResolution"};
+
+	for (int i = 0; i < PARALLAX_LAYERS; i++) {
+		layerTargets[i] = LayerTarget();
+		layerTargets[i].Create(settings.GetFloat(layerResolutions[i], 1.0f), ::width, ::height);
+	}
+
+	idleFrameSkipping = settings.GetBool("idleFrameSkipping", false);
+	idleTimeout = settings.GetFloat("idleTimeout", 0.25f);
+
+	// Never matches a real position, so the first frame is always drawn
+	lastState = simulation.State();
+	lastState.backgroundPosition = NAN;
+
+	renderThread = settings.GetBool("renderThread", false);
+	frame = Capture();
 
 	// Forcing camera setup on first run
-	resized = true;
+	viewWidth = viewHeight = 0;
+
+	AddShader("Shaders/Shader.vs", "Shaders/Shader.frag");
+
+	SetupScene();
 }
 
 void SceneManager::AddShader(string vFilename, string fFilename) {
@@ -54,11 +227,14 @@ void SceneManager::AddShader(string vFilename, string fFilename) {
 void SceneManager::KeyCallback(GLFWwindow * window, int key, int scanCode, int action, int mode) {
 	if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
 		glfwSetWindowShouldClose(window, GL_TRUE);
-	if (key >= 0 && key < 1024) {
-		if (action == GLFW_PRESS)
-			keys[key] = true;
-		else if (action == GLFW_RELEASE)
-			keys[key] = false;
+	// Repeats don't change which keys are held
+	if (key >= 0 && key < 1024 && action != GLFW_REPEAT) {
+		InputEvent event;
+		event.time = Now();
+		event.key = key;
+		event.action = action;
+
+		input.Push(event);
 	}
 }
 
@@ -66,175 +242,695 @@ void SceneManager::Resize(GLFWwindow * window, int width, int height) {
 	::width = width;
 	::height = height;
 	::resized = true;
+}
+
+void SceneManager::Refresh(GLFWwindow * window) {
+	// The window's contents were lost (e.g. uncovered), so the next frame must be drawn even if nothing moved
+	::damaged = true;
+}
+
+void SceneManager::Simulate(double time) {
+	// Replays as fast as possible step for a frame's worth of wall clock time, however far ahead of time that gets them
+	if (replayInput && replayFast) {
+		double deadline = Now() + FAST_REPLAY_TIME;
+
+		while (Now() < deadline && !respawn && !glfwWindowShouldClose(window))
+			Step();
+
+		return;
+	}
+
+	int steps = 0;
+
+	// A death stops the simulation until Respawn, which can't run in the middle of a frame
+	while (simulationTime + simulationStep <= time && steps < MAX_STEPS && !respawn && !glfwWindowShouldClose(window)) {
+		Step();
+		steps++;
+	}
+
+	// Too far behind (e.g. after a stall), the missed steps are dropped, events still go to the next step
+	if (simulationTime + simulationStep <= time && !respawn)
+		simulationTime = time - simulationStep;
+}
+
+void SceneManager::Step() {
+	simulationTime += simulationStep;
+
+	ConsumeInput(simulationTime);
+	DoMovement();
+	stepCount++;
 
-	// Define the viewport dimensions
-	glViewport(0, 0, ::width, ::height);
+	if (replayInput && recording.Finished(stepCount)) {
+		std::cout << "Replay finished: " << stepCount << " steps in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - replayStart).count() << " s" << std::endl;
+		glfwSetWindowShouldClose(window, GL_TRUE);
+	}
+}
+
+void SceneManager::ConsumeInput(double time) {
+	// Events are in time order, those after the step's end wait for the next step
+	InputEvent event;
+
+	// Replayed steps get the recorded events, live ones are dropped
+	if (replayInput) {
+		while (input.Peek(event))
+			input.Pop();
+
+		while (recording.Next(stepCount, event.key, event.action))
+			simulation.Input(event.key, event.action);
+
+		return;
+	}
+
+	while (input.Peek(event) && event.time <= time) {
+		input.Pop();
+
+		if (recordInput)
+			recording.Record(stepCount, event.key, event.action);
+
+		inputTimeSum += event.time;
+		oldestInput = inputEvents++ ? std::min(oldestInput, event.time) : event.time;
+
+		simulation.Input(event.key, event.action);
+	}
 }
 
 void SceneManager::DoMovement() {
-	if (keys[GLFW_KEY_LEFT])
-		if ((characterPosition - 0.001) > -0.95) {
-			characterPosition -= 0.001f;
-			backgroundPosition += 0.0002f;
-			foregroundPosition += 0.0005f;
-			boxPosition += 0.0005f;
-			offsetY = 1.0;
-			offsetX -= 1.0/4.0;
-
-			if(TestCollision()) {
-				Finish();
-				InitializeGraphics();
-				keys[GLFW_KEY_LEFT] = false;
-				std::cout << "You died!" << std::endl;
-			}
-		}
+	Simulation::Checkpoint checkpoint;
 
-	if (keys[GLFW_KEY_RIGHT])
-		if ((characterPosition + 0.001) < 0.95) {
-			characterPosition += 0.001f;
-			backgroundPosition -= 0.0002f;
-			foregroundPosition -= 0.0005f;
-			boxPosition -= 0.0005f;
-			offsetY = 1.0/2.0;
-			offsetX += 1.0/4.0;
-		}
+	// Held, the rewind key goes back a step instead, a tap going back a single one
+	if (rewind && (simulation.Held(GLFW_KEY_BACKSPACE) || simulation.Tapped(GLFW_KEY_BACKSPACE))) {
+		if (history.Pop(checkpoint))
+			simulation.Load(checkpoint, false);
 
-	if (keys[GLFW_KEY_ESCAPE])
+		simulation.Pause();
+		return;
+	}
+
+	// Taken before the step, so rewinding a death goes back to right before it
+	if (rewind) {
+		simulation.Save(checkpoint);
+		history.Push(checkpoint);
+	}
+
+	if (!simulation.Step())
+		respawn = true;
+	else if (simulation.Held(GLFW_KEY_ESCAPE))
 		glfwSetWindowShouldClose(window, GL_TRUE);
 }
 
+void SceneManager::Respawn() {
+	// Only the gameplay goes back to the start, keeping the keys held but the one that walked into the box
+	if (instantRespawn && simulation.Load(spawn, false)) {
+		simulation.Input(GLFW_KEY_LEFT, GLFW_RELEASE);
+		respawn = false;
+		std::cout << "You died!" << std::endl;
+		return;
+	}
+
+	// The window and its context are created again, so the render thread can't be using them
+	if (renderThread) {
+		StopRenderThread();
+		glfwMakeContextCurrent(window);
+	}
+
+	Finish();
+	InitializeGraphics();
+	std::cout << "You died!" << std::endl;
+
+	if (renderThread)
+		StartRenderThread();
+}
+
+SceneSnapshot SceneManager::Capture() {
+	SceneSnapshot snapshot;
+	static_cast<SceneState&>(snapshot) = simulation.State();
+
+	snapshot.width = ::width;
+	snapshot.height = ::height;
+
+	snapshot.inputEvents = inputEvents;
+	snapshot.inputTimeSum = inputTimeSum;
+	snapshot.oldestInput = oldestInput;
+
+	snapshot.rewindStates = history.States();
+	snapshot.rewindMemory = history.Memory();
+	snapshot.rewindCapture = history.CaptureTime();
+
+	inputEvents = 0;
+	inputTimeSum = 0.0;
+
+	return snapshot;
+}
+
+void SceneManager::TakeFrame(const SceneSnapshot &snapshot) {
+	// Input of snapshots that were taken but not presented yet stays with the frame
+	unsigned int pendingEvents = frame.inputEvents;
+	double pendingTimeSum = frame.inputTimeSum, pendingOldest = frame.oldestInput;
+
+	frame = snapshot;
+
+	if (pendingEvents) {
+		frame.oldestInput = frame.inputEvents ? std::min(frame.oldestInput, pendingOldest) : pendingOldest;
+		frame.inputEvents += pendingEvents;
+		frame.inputTimeSum += pendingTimeSum;
+	}
+}
+
+void SceneManager::LateLatch() {
+	GLfloat background = frame.backgroundPosition, foreground = frame.foregroundPosition, character = frame.characterPosition, box = frame.boxPosition;
+	glm::vec2 textureOffset(frame.offsetX, frame.offsetY);
+
+	// The render thread takes the simulation's latest snapshot, events can only be polled on the main thread
+	if (renderThread) {
+		if (!snapshots.Take())
+			return;
+
+		TakeFrame(snapshots.Front());
+	} else {
+		glfwPollEvents();
+		Simulate(Now());
+		TakeFrame(Capture());
+	}
+
+	// Culling isn't redone, a step or two of scrolling barely moves anything across the view's edges
+	glm::vec3 scroll(frame.foregroundPosition - foreground, 0, 0);
+
+	// Reduced resolution layers were already drawn, their composites are left where they are
+	renderQueue.Latch(BACKGROUND_LAYER, glm::vec3(frame.backgroundPosition - background, 0, 0), glm::vec2(0, 0));
+	renderQueue.Latch(FOREGROUND_LAYER, scroll, glm::vec2(0, 0));
+	renderQueue.Latch(STREAMED_LAYER, scroll, glm::vec2(0, 0));
+	renderQueue.Latch(BENCHMARK_LAYER, scroll, glm::vec2(0, 0));
+	renderQueue.Latch(CHARACTER_LAYER, glm::vec3(frame.characterPosition - character, 0, 0), glm::vec2(frame.offsetX, frame.offsetY) - textureOffset);
+	renderQueue.Latch(BOX_LAYER, glm::vec3(frame.boxPosition - box, 0, 0), glm::vec2(0, 0));
+}
+
+bool SceneManager::SceneChanged() {
+	// Everything a frame depends on, no shader animates with time
+	bool changed = resized || damaged || simulation.State() != lastState;
+
+	lastState = simulation.State();
+	resized = damaged = false;
+
+	return changed;
+}
+
 void SceneManager::Render() {
+	// Camera must be up to date before culling against it
+	if (frame.width != viewWidth || frame.height != viewHeight) {
+		viewWidth = frame.width;
+		viewHeight = frame.height;
+
+		// Define the viewport dimensions
+		glViewport(0, 0, viewWidth, viewHeight);
+
+		SetupCamera2D();
+		RebuildCullingGrid();
+
+		if (dynamicResolution)
+			resolution.Resize(viewWidth, viewHeight);
+
+		for (int i = 0; i < PARALLAX_LAYERS; i++)
+			layerTargets[i].Resize(viewWidth, viewHeight);
+	}
+
+	// Drawn offscreen at a scale of the window's size, upscaled once the frame is done
+	GLuint renderWidth = dynamicResolution ? resolution.Width() : viewWidth;
+	GLuint renderHeight = dynamicResolution ? resolution.Height() : viewHeight;
+
+	GLfloat time = glfwGetTime();
+	frameUniforms.Update(projection, view, renderWidth, renderHeight, time, time - lastFrameTime);
+	lastFrameTime = time;
+
+	CullScene();
+
+	// Camera position, in level coordinates before projection
+	if (streaming) {
+		AABB levelView = UnprojectBounds(ViewBounds(frame.foregroundPosition));
+		streamer.Update(0.5f * (levelView.min.x + levelView.max.x));
+	}
+
+	if (gpuCulling)
+		gpuCuller.Cull(frame.foregroundPosition);
+
+	// Every Render* function only queues its draws
+	renderQueue.Clear();
+
+	for (int i = 0; i < PARALLAX_LAYERS; i++)
+		layerQueues[i].Clear();
+
+	if (visible[BACKGROUND])
+		RenderBackground();
+	if (visible[FOREGROUND])
+		RenderForeground();
+
+	RenderTilemap();
+	RenderStreamedSprites();
+	RenderBenchmarkSprites();
+
+	if (visible[CHARACTER])
+		RenderCharacter();
+	if (visible[BOX])
+		RenderBox();
+
+	// Batched sprites are packed within the level area around the camera
+	spriteBatch.Begin(UnprojectBounds(ViewBounds(frame.foregroundPosition)));
+
+	// Reduced resolution layers are drawn first, then composited in their place by the frame's queue
+	RenderLayerTargets();
+
+	if (lateLatch)
+		LateLatch();
+
+	if (dynamicResolution)
+		resolution.Begin();
+
 	// Clear the colorbuffer
 	glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-	RenderBackground();
-	RenderForeground();
-	RenderCharacter();
-	RenderBox();
+	renderQueue.Execute(spriteBatch);
+	spriteBatch.End();
+
+	if (dynamicResolution) {
+		resolution.End();
+		stats.resolutionScale = resolution.Scale();
+		stats.gpuTime = resolution.GPUTime();
+	}
+
+	stats.queuedPackets = renderQueue.Packets();
+	stats.queueDraws = renderQueue.Draws();
+
+	for (int i = 0; i < PARALLAX_LAYERS; i++) {
+		stats.queuedPackets += layerQueues[i].Packets();
+		stats.queueDraws += layerQueues[i].Draws();
+	}
+	stats.vertexBytes = spriteBatch.VertexBytes();
+	stats.vertexBytesSaved = spriteBatch.VertexBytesSaved();
+	stats.streamWaits = spriteBatch.StreamWaits();
+
+	stats.stateCallsIssued = GLState::issued;
+	stats.stateCallsSkipped = GLState::skipped;
+	GLState::ResetCounters();
 }
 
-void SceneManager::RenderBackground(){
-	shader -> Use();
+void SceneManager::CullScene() {
+	// Parallax layers and the character don't move along with the level, so they are tested directly
+	AABB view = ViewBounds(0);
 
-	// Create transformations 
-	model = glm::mat4();
-	model = glm::translate(model, glm::vec3(backgroundPosition, 0, 0));
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsetx"), 0);
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsety"), 0);
+	visible[BACKGROUND] = ProjectBounds(objectBounds[BACKGROUND], glm::vec2(frame.backgroundPosition, 0)).Intersects(view);
+	visible[FOREGROUND] = ProjectBounds(objectBounds[FOREGROUND], glm::vec2(frame.foregroundPosition, 0)).Intersects(view);
+	visible[CHARACTER] = ProjectBounds(objectBounds[CHARACTER], glm::vec2(frame.characterPosition, frame.verticalPosition)).Intersects(view);
+	visible[BOX] = false;
 
-	GLint modelLoc = glGetUniformLocation(shader->Program, "model");
+	// Level objects are only looked up in the grid cells under the camera
+	visibleLevelObjects.clear();
+	levelGrid.Query(ViewBounds(frame.foregroundPosition), visibleLevelObjects);
 
-	// Passes transformations to Shaders
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	visibleBenchmarkSprites.clear();
 
-	if (resized) {
-		SetupCamera2D();
-		resized = false;
-	}
+	for (unsigned int id : visibleLevelObjects)
+		if (id < SCENE_OBJECTS)
+			visible[id] = true;
+		else
+			visibleBenchmarkSprites.push_back(id - SCENE_OBJECTS);
 
-	glBindTexture(GL_TEXTURE_2D, backgroundTexture);
-	glUniform1i(glGetUniformLocation(shader -> Program, "texture"), 0);
+	GLuint total = 3 + levelGrid.Size();
+	stats.visibleSprites = visible[BACKGROUND] + visible[FOREGROUND] + visible[CHARACTER] + visibleLevelObjects.size();
+
+	// Benchmark sprites are culled on the GPU, their count is only read back when printed
+	if (gpuCulling) {
+		total += gpuCuller.InstanceCount();
+		if (settings.GetBool("showStats", false) && stats.Due(lastFrameTime))
+			stats.gpuVisibleSprites = gpuCuller.VisibleCount();
+		stats.visibleSprites += stats.gpuVisibleSprites;
+	}
 
-	// Render container
-	glBindVertexArray(bgVAO);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+	stats.culledSprites = total - stats.visibleSprites;
 }
 
-void SceneManager::RenderForeground(){
-	shader -> Use();
+AABB SceneManager::UnprojectBounds(const AABB &bounds) {
+	glm::vec4 a = inverseProjection * glm::vec4(bounds.min.x, bounds.min.y, 0.0f, 1.0f);
+	glm::vec4 b = inverseProjection * glm::vec4(bounds.max.x, bounds.max.y, 0.0f, 1.0f);
 
-	// Create transformations 
-	model = glm::mat4();
-	model = glm::translate(model, glm::vec3(foregroundPosition, 0, 0));
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsetx"), 0);
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsety"), 0);
+	return AABB(
+		glm::vec2(glm::min(a.x, b.x), glm::min(a.y, b.y)),
+		glm::vec2(glm::max(a.x, b.x), glm::max(a.y, b.y))
+	);
+}
 
-	GLint modelLoc = glGetUniformLocation(shader->Program, "model");
+void SceneManager::RebuildCullingGrid() {
+	// Grid bounds are in clip space, so they depend on the projection
+	levelGrid = SpatialGrid(settings.GetFloat("cullingCellSize", 0.5f));
+	levelGrid.Insert(BOX, ProjectBounds(objectBounds[BOX], glm::vec2(frame.boxPosition - frame.foregroundPosition, frame.verticalPosition)));
 
-	// Passes transformations to Shaders
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	if (gpuCulling)
+		return;
 
-	if (resized) {
-		SetupCamera2D();
-		resized = false;
+	for (GLuint i = 0; i < benchmarkSprites.size(); i++) {
+		const SpriteInstance &sprite = benchmarkSprites[i];
+		AABB bounds(glm::vec2(-0.5f * sprite.size.x, 0.0f), glm::vec2(0.5f * sprite.size.x, sprite.size.y));
+		levelGrid.Insert(SCENE_OBJECTS + i, ProjectBounds(bounds, sprite.position));
 	}
+}
+
+AABB SceneManager::ProjectBounds(const AABB &bounds, glm::vec2 translation) {
+	// Same transformation as the vertex shader: model * projection * position
+	glm::vec4 a = projection * glm::vec4(bounds.min.x, bounds.min.y, 0.0f, 1.0f);
+	glm::vec4 b = projection * glm::vec4(bounds.max.x, bounds.max.y, 0.0f, 1.0f);
 
-	glBindTexture(GL_TEXTURE_2D, foregroundTexture);
-	glUniform1i(glGetUniformLocation(shader -> Program, "texture"), 0);
+	return AABB(
+		glm::vec2(glm::min(a.x, b.x), glm::min(a.y, b.y)) + translation,
+		glm::vec2(glm::max(a.x, b.x), glm::max(a.y, b.y)) + translation
+	);
+}
+
+RenderQueue::Blend SceneManager::TextureBlend(bool opaque) {
+	return opaquePass && opaque ? RenderQueue::BLEND_NONE : RenderQueue::BLEND_ALPHA;
+}
+
+AABB SceneManager::ViewBounds(GLfloat scroll) {
+	// The camera sees the [-1, 1] clip space square, shifted back by the layer's scroll
+	return AABB(glm::vec2(-1.0f - scroll, -1.0f), glm::vec2(1.0f - scroll, 1.0f));
+}
 
-	// Render container
-	glBindVertexArray(fgVAO);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+void SceneManager::RenderBackground(){
+	// Queued, drawn once the frame's packets are sorted
+	LayerQueue(BACKGROUND_LAYER).SubmitMesh(
+		BACKGROUND_LAYER, TextureBlend(objectOpaque[BACKGROUND]), LayerDepth(BACKGROUND_LAYER),
+		shader -> Program, backgroundTexture, bgVAO, objectIndices[BACKGROUND], objectBounds[BACKGROUND],
+		glm::vec3(frame.backgroundPosition, 0, 0), glm::vec2(0, 0)
+	);
+}
+
+void SceneManager::RenderForeground(){
+	LayerQueue(FOREGROUND_LAYER).SubmitMesh(
+		FOREGROUND_LAYER, TextureBlend(objectOpaque[FOREGROUND]), LayerDepth(FOREGROUND_LAYER),
+		shader -> Program, foregroundTexture, fgVAO, objectIndices[FOREGROUND], objectBounds[FOREGROUND],
+		glm::vec3(frame.foregroundPosition, 0, 0), glm::vec2(0, 0)
+	);
 }
 
 void SceneManager::RenderCharacter(){
-	shader -> Use();
+	renderQueue.SubmitMesh(
+		CHARACTER_LAYER, TextureBlend(objectOpaque[CHARACTER]), LayerDepth(CHARACTER_LAYER),
+		shader -> Program, characterTexture, charVAO, objectIndices[CHARACTER], objectBounds[CHARACTER],
+		glm::vec3(frame.characterPosition, frame.verticalPosition, 1), glm::vec2(frame.offsetX, frame.offsetY)
+	);
+}
 
-	// Create transformations 
-	model = glm::mat4();
-	model = glm::translate(model, glm::vec3(characterPosition, verticalPosition, 1));
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsetx"), offsetX);
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsety"), offsetY);
+void SceneManager::RenderBox(){
+	renderQueue.SubmitMesh(
+		BOX_LAYER, TextureBlend(objectOpaque[BOX]), LayerDepth(BOX_LAYER),
+		shader -> Program, boxTexture, boxVAO, objectIndices[BOX], objectBounds[BOX],
+		glm::vec3(frame.boxPosition, frame.verticalPosition, 2), glm::vec2(0, 0)
+	);
+}
 
-	GLint modelLoc = glGetUniformLocation(shader->Program, "model");
+void SceneManager::RenderBenchmarkSprites() {
+	if (gpuCulling) {
+		renderQueue.SubmitCustom(
+			BENCHMARK_LAYER, TextureBlend(objectOpaque[BOX]), LayerDepth(BENCHMARK_LAYER),
+			[this](GLfloat depth) { gpuCuller.Draw(frame.foregroundPosition, depth); }
+		);
+		return;
+	}
 
-	// Passes transformations to Shaders
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	RenderQueue::Blend blend = TextureBlend(objectOpaque[BOX]);
+	glm::vec3 translation(frame.foregroundPosition, 0, 0);
 
-	if (resized) {
-		SetupCamera2D();
-		resized = false;
+	// Quads are written before projection, so sprite translations are brought back through it
+	for (unsigned int i : visibleBenchmarkSprites) {
+		const SpriteInstance &sprite = benchmarkSprites[i];
+		glm::vec4 position = inverseProjection * glm::vec4(sprite.position.x, sprite.position.y, 0.0f, 1.0f);
+
+		AABB bounds(
+			glm::vec2(position.x - 0.5f * sprite.size.x, position.y),
+			glm::vec2(position.x + 0.5f * sprite.size.x, position.y + sprite.size.y)
+		);
+
+		renderQueue.SubmitSprite(
+			BENCHMARK_LAYER, blend, LayerDepth(BENCHMARK_LAYER),
+			batchShader -> Program, boxTexture, bounds, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), translation
+		);
 	}
+}
+
+void SceneManager::RenderTilemap() {
+	if (tilemap.ChunkCount() == 0)
+		return;
+
+	renderQueue.SubmitCustom(TILEMAP_LAYER, TextureBlend(tilemap.TilesetOpaque()), LayerDepth(TILEMAP_LAYER), [this](GLfloat depth) {
+		shader -> Use();
+
+		model = glm::mat4();
+		model = glm::translate(model, glm::vec3(frame.foregroundPosition, 0, 0));
+		glUniform1f(glGetUniformLocation(shader -> Program, "offsetx"), 0);
+		glUniform1f(glGetUniformLocation(shader -> Program, "offsety"), 0);
 
-	glBindTexture(GL_TEXTURE_2D, characterTexture);
-	glUniform1i(glGetUniformLocation(shader -> Program, "texture"), 0);
+		// Chunk vertices are floats, used as they are
+		glUniform4f(glGetUniformLocation(shader -> Program, "bounds"), 0, 0, 1, 1);
+		glUniform1f(glGetUniformLocation(shader -> Program, "depth"), depth);
 
-	// Render container
-	glBindVertexArray(charVAO);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+		GLint modelLoc = glGetUniformLocation(shader -> Program, "model");
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+
+		// Chunks are selected in tile space, before projection and scrolling
+		stats.visibleChunks = tilemap.Draw(UnprojectBounds(ViewBounds(frame.foregroundPosition)));
+		stats.chunkRebuilds = tilemap.Rebuilds();
+	});
 }
 
-void SceneManager::RenderBox(){
-	shader -> Use();
+void SceneManager::RenderStreamedSprites() {
+	if (!streaming)
+		return;
 
-	// Create transformations 
-	model = glm::mat4();
-	model = glm::translate(model, glm::vec3(boxPosition, verticalPosition, 2));
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsetx"), 0);
-	glUniform1f(glGetUniformLocation(shader -> Program, "offsety"), 0);
+	visibleStreamedSprites.clear();
+	streamer.VisibleSprites(UnprojectBounds(ViewBounds(frame.foregroundPosition)), visibleStreamedSprites);
 
-	GLint modelLoc = glGetUniformLocation(shader -> Program, "model");
+	stats.loadedSegments = streamer.LoadedSegments();
+	stats.pendingSegments = streamer.PendingSegments();
+	stats.streamingMemory = streamer.MemoryUsage();
 
-	// Passes transformations to Shaders
-	glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+	glm::vec3 translation(frame.foregroundPosition, 0, 0);
 
-	if (resized) {
-		SetupCamera2D();
-		resized = false;
+	// The queue groups them by texture
+	for (const LevelStreamer::Sprite *sprite : visibleStreamedSprites) {
+		GLuint texture = streamer.Texture(sprite -> textureSlot);
+
+		// Streamed sprites are already placed before projection
+		AABB bounds(
+			glm::vec2(sprite -> position.x - 0.5f * sprite -> size.x, sprite -> position.y),
+			glm::vec2(sprite -> position.x + 0.5f * sprite -> size.x, sprite -> position.y + sprite -> size.y)
+		);
+
+		renderQueue.SubmitSprite(
+			STREAMED_LAYER, TextureBlend(streamer.TextureOpaque(sprite -> textureSlot)), LayerDepth(STREAMED_LAYER),
+			batchShader -> Program, texture, bounds, glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f), translation
+		);
 	}
+}
+
+void SceneManager::RenderLayerTargets() {
+	for (int i = 0; i < PARALLAX_LAYERS; i++) {
+		if (!layerTargets[i].Enabled() || layerQueues[i].Packets() == 0)
+			continue;
+
+		layerTargets[i].Begin();
+		layerQueues[i].Execute(spriteBatch);
+		layerTargets[i].End(viewWidth, viewHeight);
 
-	glBindTexture(GL_TEXTURE_2D, boxTexture);
-	glUniform1i(glGetUniformLocation(shader -> Program, "texture"), 0);
+		// Blended, as the target is transparent wherever the layer isn't drawn
+		LayerTarget *target = &layerTargets[i];
+		renderQueue.SubmitCustom(i, RenderQueue::BLEND_ALPHA, LayerDepth((SceneLayer)i), [target](GLfloat depth) {
+			target -> Composite(depth);
+		});
+	}
+}
 
-	// Render container
-	glBindVertexArray(boxVAO);
-	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+RenderQueue &SceneManager::LayerQueue(SceneLayer layer) {
+	if (layer < PARALLAX_LAYERS && layerTargets[layer].Enabled())
+		return layerQueues[layer];
 
-	glBindVertexArray(0);
+	return renderQueue;
 }
 
 void SceneManager::Run() {
+	if (headless) {
+		RunHeadless();
+		return;
+	}
+
+	// Not GLFW's timer, which starts over with every respawn's glfwInit
+	replayStart = std::chrono::steady_clock::now();
+
+	if (renderThread)
+		RunThreaded();
+	else
+		RunSerial();
+
+	// The session's last step ends the recording
+	if (recordInput)
+		recording.Close(stepCount);
+}
+
+void SceneManager::RunSerial() {
+	bool idle = false;
+
 	// Game Loop
 	while (!glfwWindowShouldClose(window)) {
-		glfwPollEvents();
-		DoMovement();
-		Render();
-		glfwSwapBuffers(window);
+		// Nothing changed last time, so sleep until an event arrives (or the timeout, in case something is missed)
+		if (idle)
+			glfwWaitEventsTimeout(idleTimeout);
+		else
+			glfwPollEvents();
+
+		Simulate(Now());
+
+		if (respawn)
+			Respawn();
+
+		// Streamed segments and textures keep arriving while the camera stands still
+		idle = idleFrameSkipping && !SceneChanged() && !(streaming && streamer.Busy());
+
+		// Input that changed nothing was never shown, so it isn't measured either
+		if (idle) {
+			limiter.Restart();
+			inputEvents = 0;
+			inputTimeSum = 0.0;
+			continue;
+		}
+
+		TakeFrame(Capture());
+		DrawFrame();
+	}
+}
+
+void SceneManager::RunThreaded() {
+	StartRenderThread();
+
+	while (!glfwWindowShouldClose(window)) {
+		// Sleeps until input arrives or the next step is due, fast replays don't wait for either
+		if (replayInput && replayFast)
+			glfwPollEvents();
+		else
+			glfwWaitEventsTimeout(std::max(simulationTime + simulationStep - Now(), 0.0));
+
+		Simulate(Now());
+
+		if (respawn)
+			Respawn();
+
+		if (idleFrameSkipping && !SceneChanged()) {
+			inputEvents = 0;
+			inputTimeSum = 0.0;
+			continue;
+		}
+
+		snapshots.Back() = Capture();
+		snapshots.Publish();
+	}
+
+	StopRenderThread();
+
+	// Finish cleans up from the main thread
+	glfwMakeContextCurrent(window);
+}
+
+void SceneManager::RunHeadless() {
+	HeadlessSimulation sessions;
+
+	sessions.Run(
+		settings.GetInt("headlessSessions", 1),
+		settings.GetInt("headlessSteps", 36000),
+		settings.GetString("inputReplay", ""),
+		seed,
+		&jobs
+	);
+
+	sessions.Report();
+}
+
+void SceneManager::StartRenderThread() {
+	// A context can only be current on one thread at a time
+	glfwMakeContextCurrent(NULL);
+
+	rendering = true;
+	renderer = thread(&SceneManager::RenderLoop, this);
+}
+
+void SceneManager::StopRenderThread() {
+	rendering = false;
+	snapshots.Interrupt();
+
+	if (renderer.joinable())
+		renderer.join();
+}
+
+void SceneManager::RenderLoop() {
+	glfwMakeContextCurrent(window);
+
+	while (rendering) {
+		bool fresh = snapshots.Take();
+
+		if (fresh)
+			TakeFrame(snapshots.Front());
+
+		// Frames are drawn at the display's pace, from the latest snapshot, unless nothing changed since the last one
+		if (idleFrameSkipping && !fresh && !(streaming && streamer.Busy())) {
+			limiter.Restart();
+			snapshots.Wait(idleTimeout);
+			continue;
+		}
+
+		DrawFrame();
+	}
+
+	// A snapshot published right before stopping is still shown, e.g. the last step of a fast replay
+	if (snapshots.Take()) {
+		TakeFrame(snapshots.Front());
+		DrawFrame();
+	}
+
+	glfwMakeContextCurrent(NULL);
+}
+
+void SceneManager::DrawFrame() {
+	Render();
+	glfwSwapBuffers(window);
+
+	// Latency up to the swap, the display may still take up to a refresh to show it
+	if (frame.inputEvents) {
+		double presented = Now();
+
+		stats.inputLatency += (frame.inputEvents * presented - frame.inputTimeSum) * 1000.0;
+		stats.worstInputLatency = std::max(stats.worstInputLatency, (presented - frame.oldestInput) * 1000.0);
+		stats.inputEvents += frame.inputEvents;
+
+		frame.inputEvents = 0;
+		frame.inputTimeSum = 0.0;
+	}
+
+	limiter.Wait();
+
+	if (settings.GetBool("showStats", false)) {
+		stats.rewindSeconds = frame.rewindStates * simulationStep;
+		stats.rewindMemory = frame.rewindMemory;
+		stats.rewindCapture = frame.rewindCapture;
+
+		if (stats.Due(lastFrameTime)) {
+			stats.frameInterval = limiter.MeanInterval();
+			stats.frameJitter = limiter.Jitter();
+			stats.worstFrameInterval = limiter.WorstInterval();
+			stats.lateFrames = limiter.LateFrames();
+			limiter.ResetStats();
+		}
+
+		stats.Report(lastFrameTime);
 	}
 }
 
 void SceneManager::Finish() {
+	streamer.Stop();
 	glfwTerminate();
 }
 
@@ -243,16 +939,50 @@ void SceneManager::SetupCamera2D() {
 	float ratio;
 	float xMin = -1.0, xMax = 1.0, yMin = -1.0, yMax = 1.0, zNear = -1.0, zFar = 1.0;
 
-	if (width >= height) {
-		ratio = width / (float)height;
+	if (viewWidth >= viewHeight) {
+		ratio = viewWidth / (float)viewHeight;
 		projection = glm::ortho(xMin*ratio, xMax*ratio, yMin, yMax, zNear, zFar);
 	} else {
-		ratio = height / (float)width;
+		ratio = viewHeight / (float)viewWidth;
 		projection = glm::ortho(xMin, xMax, yMin*ratio, yMax*ratio, zNear, zFar);
 	}
 
-	GLint projLoc = glGetUniformLocation(shader->Program, "projection");
-	glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+	inverseProjection = glm::inverse(projection);
+
+	// The scene scrolls its layers instead of moving the camera
+	view = glm::mat4();
+}
+
+void SceneManager::SetupFramePacing() {
+	// Vsync: "on" waits for every vertical blank, "off" never does, "adaptive" only when the frame is on time
+	string vsync = settings.GetString("vsync", "on");
+
+	// Fast replays are never held back by the display
+	bool unpaced = replayInput && replayFast;
+
+	if (unpaced)
+		vsync = "off";
+
+	if (vsync == "adaptive" && !GLExtensions::swapControlTear) {
+		std::cout << "Adaptive vsync is not available, using vsync" << std::endl;
+		vsync = "on";
+	}
+
+	if (vsync == "adaptive")
+		glfwSwapInterval(-1);
+	else if (vsync == "off")
+		glfwSwapInterval(0);
+	else
+		glfwSwapInterval(1);
+
+	// A limit of 0 leaves the pace to vsync (or to nothing), intervals are still measured
+	GLfloat frameRate = unpaced ? 0.0f : settings.GetFloat("frameRateLimit", 0.0f);
+
+	limiter = FrameLimiter();
+	limiter.Create(
+		frameRate > 0.0f ? 1.0 / frameRate : 0.0,
+		settings.GetFloat("frameLimiterSpin", 1.0f) / 1000.0
+	);
 }
 
 void SceneManager::SetupScene() {
@@ -265,8 +995,18 @@ void SceneManager::SetupScene() {
 	SetupBox();	
 	RenderBox();
 
+	SetupBenchmarkSprites();
+	SetupSpriteBatch();
+
+	SetupTilemap();
+	SetupLevelStreaming();
+
 	SetupCharacter();
 	RenderCharacter();
+
+	if (settings.GetBool("showStats", false))
+		std::cout << "Trimmed sprites: foreground " << foregroundMesh.Coverage() * 100.0f << "% of its quad in " << foregroundMesh.RectangleCount()
+			<< " rectangles, character " << characterMesh.Coverage() * 100.0f << "% in " << characterMesh.RectangleCount() << std::endl;
 }
 
 void SceneManager::SetupBackground(){
@@ -294,31 +1034,33 @@ void SceneManager::SetupBackground(){
 		1, 2, 3 
 	};
 
+	objectIndices[BACKGROUND] = 6;
+	objectBounds[BACKGROUND] = QuadBounds(background);
+
+	// Uploaded packed, positions relative to the quad's bounds
+	SpriteVertex bgVertices[4];
+	PackQuad(background, objectBounds[BACKGROUND], bgVertices);
+
 	unsigned int bgVBO, bgEBO;
 
 	glGenVertexArrays(1, &bgVAO);
 	glGenBuffers(1, &bgVBO);
 	glGenBuffers(1, &bgEBO);
 
-	glBindVertexArray(bgVAO);
+	GLState::BindVertexArray(bgVAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, bgVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(background), background, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, bgVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(bgVertices), bgVertices, GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, bgEBO);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, bgEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-	// Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Texture coords
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
+	// Position, color and texture coords
+	SpriteVertex::SetupAttributes();
 
 	SetupBackgroundTexture();
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 void SceneManager::SetupForeground(){
@@ -340,11 +1082,16 @@ void SceneManager::SetupForeground(){
 		-4.000f,	 1.000f, -1.0f,	0.5f, 0.5f, 0.5f,	 0.0,		 1.0 
 	};
 	
-	// First line = first triangle and so on
-	unsigned int indices[] = {
-		0, 1, 3,
-		1, 2, 3 
-	};
+	objectBounds[FOREGROUND] = QuadBounds(foreground);
+
+	// Trimmed while the texture loads
+	SetupForegroundTexture();
+
+	// Uploaded packed, positions relative to the quad's bounds, only over the parts of the frame with visible pixels
+	vector<SpriteVertex> fgVertices;
+	vector<GLuint> indices;
+	foregroundMesh.Build(foreground, objectBounds[FOREGROUND], fgVertices, indices);
+	objectIndices[FOREGROUND] = indices.size();
 
 	unsigned int fgVBO, fgEBO;
 
@@ -352,25 +1099,18 @@ void SceneManager::SetupForeground(){
 	glGenBuffers(1, &fgVBO);
 	glGenBuffers(1, &fgEBO);
 
-	glBindVertexArray(fgVAO);
+	GLState::BindVertexArray(fgVAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, fgVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(foreground), foreground, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, fgVBO);
+	glBufferData(GL_ARRAY_BUFFER, fgVertices.size() * sizeof(SpriteVertex), fgVertices.data(), GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, fgEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, fgEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
-	// Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	// Position, color and texture coords
+	SpriteVertex::SetupAttributes();
 
-	// Texture coords
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	SetupForegroundTexture();
-
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 void SceneManager::SetupCharacter(){
@@ -392,11 +1132,16 @@ void SceneManager::SetupCharacter(){
 		-0.125f,	 0.239f, 1.0f,	1.0f, 1.0f, 0.0f,	0.0f,		1.0/2.0  
 	};
 	
-	// First line = first triangle and so on
-	unsigned int indices[] = {
-		0, 1, 3,
-		1, 2, 3 
-	};
+	objectBounds[CHARACTER] = QuadBounds(character);
+
+	// Trimmed while the texture loads
+	SetupCharacterTexture();
+
+	// Uploaded packed, positions relative to the quad's bounds, only over the parts of the frame with visible pixels
+	vector<SpriteVertex> charVertices;
+	vector<GLuint> indices;
+	characterMesh.Build(character, objectBounds[CHARACTER], charVertices, indices);
+	objectIndices[CHARACTER] = indices.size();
 
 	unsigned int charVBO, charEBO;
 
@@ -404,25 +1149,18 @@ void SceneManager::SetupCharacter(){
 	glGenBuffers(1, &charVBO);
 	glGenBuffers(1, &charEBO);
 
-	glBindVertexArray(charVAO);
-
-	glBindBuffer(GL_ARRAY_BUFFER, charVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(character), character, GL_STATIC_DRAW);
+	GLState::BindVertexArray(charVAO);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, charEBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, charVBO);
+	glBufferData(GL_ARRAY_BUFFER, charVertices.size() * sizeof(SpriteVertex), charVertices.data(), GL_STATIC_DRAW);
 
-	// Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, charEBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
 
-	// Texture coords
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
-
-	SetupCharacterTexture();
+	// Position, color and texture coords
+	SpriteVertex::SetupAttributes();
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 void SceneManager::SetupBox(){
@@ -450,36 +1188,100 @@ void SceneManager::SetupBox(){
 		1, 2, 3 
 	};
 
+	objectIndices[BOX] = 6;
+	objectBounds[BOX] = QuadBounds(box);
+
+	// Uploaded packed, positions relative to the quad's bounds
+	SpriteVertex boxVertices[4];
+	PackQuad(box, objectBounds[BOX], boxVertices);
+
 	unsigned int boxVBO, boxEBO;
 
 	glGenVertexArrays(1, &boxVAO);
 	glGenBuffers(1, &boxVBO);
 	glGenBuffers(1, &boxEBO);
 
-	glBindVertexArray(boxVAO);
+	GLState::BindVertexArray(boxVAO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(box), box, GL_STATIC_DRAW);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, boxVBO);
+	glBufferData(GL_ARRAY_BUFFER, sizeof(boxVertices), boxVertices, GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEBO);
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxEBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
 
-	// Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	glEnableVertexAttribArray(0);
-
-	// Texture coords
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	glEnableVertexAttribArray(2);
+	// Position, color and texture coords
+	SpriteVertex::SetupAttributes();
 
 	SetupBoxTexture();
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
+}
+
+void SceneManager::SetupBenchmarkSprites() {
+	benchmarkSprites.clear();
+
+	int count = settings.GetInt("benchmarkSprites", 0);
+	float spread = settings.GetFloat("benchmarkSpread", 20.0f);
+
+	// Fixed seed, so every run draws the same level (recorded with the input, see InputRecording)
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> x(-spread, spread), y(-1.0f, 0.8f), scale(0.3f, 1.0f);
+
+	glm::vec2 boxSize = objectBounds[BOX].max - objectBounds[BOX].min;
+
+	for (int i = 0; i < count; i++)
+		benchmarkSprites.push_back(SpriteInstance(
+			glm::vec2(x(random), y(random)),
+			boxSize * scale(random),
+			glm::vec2(0.0f, 0.0f),
+			glm::vec2(1.0f, 1.0f),
+			0.0f
+		));
+
+	if (gpuCulling)
+		gpuCuller.Initialize(benchmarkSprites, boxTexture);
+}
+
+void SceneManager::SetupSpriteBatch() {
+	// Previous GL objects died with the old context, if any
+	spriteBatch = SpriteBatch();
+	spriteBatch.Create(std::max(settings.GetInt("spriteBatchCapacity", 16384), 1), pulledSprites);
+
+	batchShader = pulledSprites ? new Shader("Shaders/Pulled.vs", "Shaders/Shader.frag") : shader;
+
+	// Large runs of batched sprites are written into the stream by jobs
+	renderQueue.SetJobs(
+		settings.GetBool("parallelSpriteBatch", true) ? &jobs : NULL,
+		std::max(settings.GetInt("parallelSpriteMin", 4096), 1),
+		std::max(settings.GetInt("parallelSpriteGrain", 1024), 1)
+	);
+}
+
+void SceneManager::SetupTilemap() {
+	// Previous GL objects died with the old context, if any
+	tilemap = Tilemap();
+
+	string levelMap = settings.GetString("levelMap", "");
+	if (!levelMap.empty())
+		tilemap.Load(levelMap);
+}
+
+void SceneManager::SetupLevelStreaming() {
+	string levelDirectory = settings.GetString("levelDirectory", "");
+
+	streaming = !levelDirectory.empty() && streamer.Start(
+		levelDirectory,
+		&tilemap,
+		settings.GetFloat("streamingLookahead", 4.0f),
+		(size_t)(settings.GetFloat("streamingMemoryCap", 64.0f) * 1024 * 1024),
+		&jobs,
+		settings.GetInt("streamingWorkers", 2)
+	);
 }
 
 void SceneManager::SetupBackgroundTexture(){
 	glGenTextures(1, &backgroundTexture);
-	glBindTexture(GL_TEXTURE_2D, backgroundTexture); 
+	GLState::BindTexture(GL_TEXTURE_2D, backgroundTexture); 
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -490,6 +1292,7 @@ void SceneManager::SetupBackgroundTexture(){
 	// Loads image, creates texture and generates mipmaps
 	int bgWidth, bgHeight, bgNrChannels;
 	unsigned char *bgData = stbi_load("Resources/Background.jpg", &bgWidth, &bgHeight, &bgNrChannels, 0);
+	objectOpaque[BACKGROUND] = ImageAlpha::Opaque(bgData, bgWidth, bgHeight, bgNrChannels);
 
 	if (bgData) {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, bgWidth, bgHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, bgData);
@@ -499,17 +1302,17 @@ void SceneManager::SetupBackgroundTexture(){
 	}
 	stbi_image_free(bgData);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	glActiveTexture(GL_TEXTURE0);
+	GLState::ActiveTexture(GL_TEXTURE0);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void SceneManager::SetupForegroundTexture(){
 	glGenTextures(1, &foregroundTexture);
-	glBindTexture(GL_TEXTURE_2D, foregroundTexture); 
+	GLState::BindTexture(GL_TEXTURE_2D, foregroundTexture); 
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -520,6 +1323,8 @@ void SceneManager::SetupForegroundTexture(){
 	// Loads image, creates texture and generates mipmaps
 	int fgWidth, fgHeight, fgNrChannels;
 	unsigned char *fgData = stbi_load("Resources/Foreground.png", &fgWidth, &fgHeight, &fgNrChannels, 0);
+	objectOpaque[FOREGROUND] = ImageAlpha::Opaque(fgData, fgWidth, fgHeight, fgNrChannels);
+	foregroundMesh.Trim(fgData, fgWidth, fgHeight, fgNrChannels, 1, 1, settings.GetInt("spriteTrimCells", 32));
 
 	if (fgData) {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, fgWidth, fgHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, fgData);
@@ -529,17 +1334,17 @@ void SceneManager::SetupForegroundTexture(){
 	}
 	stbi_image_free(fgData);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	glActiveTexture(GL_TEXTURE0);
+	GLState::ActiveTexture(GL_TEXTURE0);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void SceneManager::SetupCharacterTexture() {
 	glGenTextures(1, &characterTexture);
-	glBindTexture(GL_TEXTURE_2D, characterTexture); 
+	GLState::BindTexture(GL_TEXTURE_2D, characterTexture); 
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);	
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -550,6 +1355,10 @@ void SceneManager::SetupCharacterTexture() {
 	// Loads image, creates texture and generates mipmaps
 	int charWidth, charHeight, charNrChannels;
 	unsigned char *charData = stbi_load("Resources/Character.png", &charWidth, &charHeight, &charNrChannels, 0);
+	objectOpaque[CHARACTER] = ImageAlpha::Opaque(charData, charWidth, charHeight, charNrChannels);
+
+	// 4 x 2 frames, shown by moving the texture offset (see DoMovement)
+	characterMesh.Trim(charData, charWidth, charHeight, charNrChannels, 4, 2, settings.GetInt("spriteTrimCells", 32));
 
 	if (charData) {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, charWidth, charHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, charData);
@@ -559,20 +1368,21 @@ void SceneManager::SetupCharacterTexture() {
 	}
 	stbi_image_free(charData);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	glActiveTexture(GL_TEXTURE0);
+	GLState::ActiveTexture(GL_TEXTURE0);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
 
 void SceneManager::SetupBoxTexture(){
 	glGenTextures(1, &boxTexture);
-	glBindTexture(GL_TEXTURE_2D, boxTexture); 
+	GLState::BindTexture(GL_TEXTURE_2D, boxTexture); 
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);	
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+	// Clamped to its edge, as a transparent border would make the filtered edges translucent
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);	
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -580,6 +1390,7 @@ void SceneManager::SetupBoxTexture(){
 	// Loads image, creates texture and generates mipmaps
 	int boxWidth, boxHeight, boxNrChannels;
 	unsigned char *boxData = stbi_load("Resources/TNT.jpg", &boxWidth, &boxHeight, &boxNrChannels, 0);
+	objectOpaque[BOX] = ImageAlpha::Opaque(boxData, boxWidth, boxHeight, boxNrChannels);
 
 	if (boxData) {
 		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, boxWidth, boxHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, boxData);
@@ -589,16 +1400,10 @@ void SceneManager::SetupBoxTexture(){
 	}
 	stbi_image_free(boxData);
 
-	glBindTexture(GL_TEXTURE_2D, 0);
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
 
-	glActiveTexture(GL_TEXTURE0);
-
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-}
+	GLState::ActiveTexture(GL_TEXTURE0);
 
-bool SceneManager::TestCollision(){
-	if (characterPosition <= boxPosition + 0.075)
-		return true;
-	return false;
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 }
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include <Classes/Settings.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdlib>
+
+void Settings::Load(string filename) {
+	std::ifstream file(filename.c_str());
+
+	if (!file) {
+		std::cout << "Failed to open settings file, using defaults" << std::endl;
+		return;
+	}
+
+	std::stringstream stream;
+	stream << file.rdbuf();
+	string content = stream.str();
+
+	size_t position = 0;
+
+	while ((position = content.find('"', position)) != string::npos) {
+		size_t keyEnd = content.find('"', position + 1);
+		if (keyEnd == string::npos)
+			break;
+
+		string key = content.substr(position + 1, keyEnd - position - 1);
+
+		size_t colon = content.find_first_not_of(" \t\r\n", keyEnd + 1);
+		if (colon == string::npos || content[colon] != ':') {
+			position = keyEnd + 1;
+			continue;
+		}
+
+		size_t valueStart = content.find_first_not_of(" \t\r\n", colon + 1);
+		if (valueStart == string::npos)
+			break;
+
+		string value;
+
+		if (content[valueStart] == '"') {
+			size_t valueEnd = content.find('"', valueStart + 1);
+			if (valueEnd == string::npos)
+				break;
+
+			value = content.substr(valueStart + 1, valueEnd - valueStart - 1);
+			position = valueEnd + 1;
+		} else {
+			size_t valueEnd = content.find_first_of(",}\r\n", valueStart);
+			if (valueEnd == string::npos)
+				valueEnd = content.size();
+
+			value = content.substr(valueStart, valueEnd - valueStart);
+			value.erase(value.find_last_not_of(" \t") + 1);
+			position = valueEnd;
+		}
+
+		values[key] = value;
+	}
+}
+
+bool Settings::GetBool(string key, bool fallback) {
+	auto value = values.find(key);
+	if (value == values.end())
+		return fallback;
+
+	return value -> second == "true";
+}
+
+int Settings::GetInt(string key, int fallback) {
+	auto value = values.find(key);
+	if (value == values.end())
+		return fallback;
+
+	return atoi(value -> second.c_str());
+}
+
+float Settings::GetFloat(string key, float fallback) {
+	auto value = values.find(key);
+	if (value == values.end())
+		return fallback;
+
+	return (float)atof(value -> second.c_str());
+}
+
+string Settings::GetString(string key, string fallback) {
+	auto value = values.find(key);
+	if (value == values.end())
+		return fallback;
+
+	return value -> second;
+}
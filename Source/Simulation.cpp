@@ -0,0 +1,123 @@
+#include <Classes/Simulation.h>
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <cstring>
+
+static const char CHECKPOINT_MAGIC[4] = {'T', 'G', 'A', 'S'};
+
+Simulation::Simulation() {
+	for (int i = 0; i < KEYS; i++)
+		keys[i] = tapped[i] = false;
+
+	Reset();
+}
+
+void Simulation::Reset() {
+	state.backgroundPosition = 0.0;
+	state.foregroundPosition = 0.0;
+	state.characterPosition = 0.85;
+	state.boxPosition = -0.85;
+	state.verticalPosition = -0.275;
+	state.offsetX = 0.0;
+	state.offsetY = 0.0;
+
+	keys[GLFW_KEY_LEFT] = tapped[GLFW_KEY_LEFT] = false;
+}
+
+void Simulation::Input(int key, int action) {
+	if (key < 0 || key >= KEYS)
+		return;
+
+	if (action == GLFW_PRESS)
+		keys[key] = tapped[key] = true;
+	else if (action == GLFW_RELEASE)
+		keys[key] = false;
+}
+
+bool Simulation::Step() {
+	bool alive = true;
+
+	// A key tapped between two steps still moves for one step
+	if (keys[GLFW_KEY_LEFT] || tapped[GLFW_KEY_LEFT])
+		if ((state.characterPosition - 0.001) > -0.95) {
+			state.characterPosition -= 0.001f;
+			state.backgroundPosition += 0.0002f;
+			state.foregroundPosition += 0.0005f;
+			state.boxPosition += 0.0005f;
+			state.offsetY = 1.0;
+			state.offsetX -= 1.0/4.0;
+
+			alive = !TestCollision();
+		}
+
+	if (alive && (keys[GLFW_KEY_RIGHT] || tapped[GLFW_KEY_RIGHT]))
+		if ((state.characterPosition + 0.001) < 0.95) {
+			state.characterPosition += 0.001f;
+			state.backgroundPosition -= 0.0002f;
+			state.foregroundPosition -= 0.0005f;
+			state.boxPosition -= 0.0005f;
+			state.offsetY = 1.0/2.0;
+			state.offsetX += 1.0/4.0;
+		}
+
+	Pause();
+
+	return alive;
+}
+
+void Simulation::Pause() {
+	for (int i = 0; i < KEYS; i++)
+		tapped[i] = false;
+}
+
+void Simulation::Save(Checkpoint &checkpoint) {
+	// No stale bytes, so equal simulations always give equal checkpoints
+	memset(&checkpoint, 0, sizeof(Checkpoint));
+
+	memcpy(checkpoint.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+	checkpoint.version = CHECKPOINT_VERSION;
+	checkpoint.size = sizeof(Checkpoint);
+	checkpoint.state = state;
+
+	for (int i = 0; i < KEYS; i++) {
+		checkpoint.keys[i / 32] |= (unsigned int)keys[i] << (i % 32);
+		checkpoint.tapped[i / 32] |= (unsigned int)tapped[i] << (i % 32);
+	}
+}
+
+bool Simulation::Load(const Checkpoint &checkpoint, bool input) {
+	if (memcmp(checkpoint.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) || checkpoint.version != CHECKPOINT_VERSION || checkpoint.size != sizeof(Checkpoint)) {
+		std::cout << "Checkpoint of version " << checkpoint.version << " can't be loaded, expected version " << CHECKPOINT_VERSION << std::endl;
+		return false;
+	}
+
+	state = checkpoint.state;
+
+	if (!input)
+		return true;
+
+	for (int i = 0; i < KEYS; i++) {
+		keys[i] = (checkpoint.keys[i / 32] >> (i % 32)) & 1;
+		tapped[i] = (checkpoint.tapped[i / 32] >> (i % 32)) & 1;
+	}
+
+	return true;
+}
+
+bool Simulation::Held(int key) {
+	return key >= 0 && key < KEYS && keys[key];
+}
+
+bool Simulation::Tapped(int key) {
+	return key >= 0 && key < KEYS && tapped[key];
+}
+
+const SceneState &Simulation::State() {
+	return state;
+}
+
+bool Simulation::TestCollision() {
+	if (state.characterPosition <= state.boxPosition + 0.075)
+		return true;
+	return false;
+}
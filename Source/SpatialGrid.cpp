@@ -0,0 +1,102 @@
+#include <Classes/SpatialGrid.h>
+#include <algorithm>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float cellSize) {
+	this -> cellSize = cellSize;
+	size = 0;
+	queryStamp = 0;
+}
+
+void SpatialGrid::Clear() {
+	cells.clear();
+	bounds.clear();
+	inserted.clear();
+	stamps.clear();
+	size = 0;
+	queryStamp = 0;
+}
+
+void SpatialGrid::Insert(unsigned int id, const AABB &bounds) {
+	if (id >= this -> bounds.size()) {
+		this -> bounds.resize(id + 1);
+		inserted.resize(id + 1, false);
+		stamps.resize(id + 1, 0);
+	}
+
+	if (inserted[id])
+		Remove(id);
+
+	this -> bounds[id] = bounds;
+	inserted[id] = true;
+	size++;
+
+	int xMin, yMin, xMax, yMax;
+	CellRange(bounds, xMin, yMin, xMax, yMax);
+
+	for (int y = yMin; y <= yMax; y++)
+		for (int x = xMin; x <= xMax; x++)
+			cells[CellKey(x, y)].push_back(id);
+}
+
+void SpatialGrid::Remove(unsigned int id) {
+	if (id >= inserted.size() || !inserted[id])
+		return;
+
+	int xMin, yMin, xMax, yMax;
+	CellRange(bounds[id], xMin, yMin, xMax, yMax);
+
+	for (int y = yMin; y <= yMax; y++)
+		for (int x = xMin; x <= xMax; x++) {
+			auto cell = cells.find(CellKey(x, y));
+			if (cell == cells.end())
+				continue;
+
+			std::vector<unsigned int> &ids = cell -> second;
+			ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+			if (ids.empty())
+				cells.erase(cell);
+		}
+
+	inserted[id] = false;
+	size--;
+}
+
+void SpatialGrid::Query(const AABB &area, std::vector<unsigned int> &result) {
+	// Objects spanning several cells are reported once, using a per-query stamp
+	queryStamp++;
+
+	int xMin, yMin, xMax, yMax;
+	CellRange(area, xMin, yMin, xMax, yMax);
+
+	for (int y = yMin; y <= yMax; y++)
+		for (int x = xMin; x <= xMax; x++) {
+			auto cell = cells.find(CellKey(x, y));
+			if (cell == cells.end())
+				continue;
+
+			for (unsigned int id : cell -> second) {
+				if (stamps[id] == queryStamp)
+					continue;
+				stamps[id] = queryStamp;
+
+				if (bounds[id].Intersects(area))
+					result.push_back(id);
+			}
+		}
+}
+
+unsigned int SpatialGrid::Size() {
+	return size;
+}
+
+long long SpatialGrid::CellKey(int x, int y) {
+	return ((long long)x << 32) | (unsigned int)y;
+}
+
+void SpatialGrid::CellRange(const AABB &area, int &xMin, int &yMin, int &xMax, int &yMax) {
+	xMin = (int)std::floor(area.min.x / cellSize);
+	yMin = (int)std::floor(area.min.y / cellSize);
+	xMax = (int)std::floor(area.max.x / cellSize);
+	yMax = (int)std::floor(area.max.y / cellSize);
+}
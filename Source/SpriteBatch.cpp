@@ -0,0 +1,197 @@
+#include <Classes/SpriteBatch.h>
+#include <Classes/GLExtensions.h>
+#include <Classes/GLState.h>
+#include <vector>
+#include <algorithm>
+
+SpriteBatch::SpriteBatch() {
+	pulled = false;
+	VAO = 0;
+	EBO = 0;
+	capacity = 0;
+	added = 0;
+	pending = 0;
+	offset = 0;
+	frameBytes = 0;
+	writer = NULL;
+}
+
+void SpriteBatch::Create(GLuint capacity, bool pulled) {
+	this -> capacity = capacity;
+	this -> pulled = pulled;
+
+	// One region holds a whole frame
+	stream.Create(pulled ? GL_SHADER_STORAGE_BUFFER : GL_ARRAY_BUFFER, capacity * SpriteBytes());
+
+	// Core profiles still need a VAO bound to draw, even without attributes
+	glGenVertexArrays(1, &VAO);
+
+	if (pulled)
+		return;
+
+	std::vector<GLuint> indices;
+	indices.reserve(capacity * 6);
+
+	for (GLuint sprite = 0; sprite < capacity; sprite++) {
+		GLuint first = sprite * 4;
+		GLuint quad[] = {
+			first + 0, first + 1, first + 3,
+			first + 1, first + 2, first + 3
+		};
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+
+	glGenBuffers(1, &EBO);
+
+	GLState::BindVertexArray(VAO);
+
+	GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+
+	GLState::BindBuffer(GL_ARRAY_BUFFER, stream.Buffer());
+
+	// Position, color and texture coords
+	SpriteVertex::SetupAttributes();
+
+	GLState::BindVertexArray(0);
+}
+
+void SpriteBatch::Begin(const AABB &area) {
+	glm::vec2 size = area.max - area.min;
+	bounds = AABB(area.min - size, area.max + size);
+
+	stream.BeginFrame();
+	added = 0;
+	pending = 0;
+	frameBytes = 0;
+	writer = NULL;
+}
+
+bool SpriteBatch::Add(const AABB &bounds, glm::vec2 uvMin, glm::vec2 uvMax) {
+	if (added == capacity || !Map())
+		return false;
+
+	Write(pending, bounds, uvMin, uvMax);
+
+	added++;
+	pending++;
+
+	return true;
+}
+
+GLuint SpriteBatch::AddParallel(GLuint count, JobSystem &jobs, GLuint grain, function<void(GLuint index, AABB &bounds, glm::vec2 &uvMin, glm::vec2 &uvMax)> fetch) {
+	count = std::min(count, capacity - added);
+
+	if (count == 0 || !Map())
+		return 0;
+
+	// Each job writes its own range of quads, after the ones already pending
+	GLuint first = pending;
+
+	jobs.ParallelFor(count, grain, [this, first, &fetch](size_t begin, size_t end) {
+		AABB bounds;
+		glm::vec2 uvMin, uvMax;
+
+		for (size_t i = begin; i < end; i++) {
+			fetch(i, bounds, uvMin, uvMax);
+			Write(first + i, bounds, uvMin, uvMax);
+		}
+	});
+
+	added += count;
+	pending += count;
+
+	return count;
+}
+
+bool SpriteBatch::Map() {
+	// Maps what's left of the frame's region on the first quad after a flush
+	if (!writer) {
+		GLsizeiptr available;
+		writer = stream.Map((capacity - added) * SpriteBytes(), SpriteBytes(), offset, available);
+	}
+
+	return writer != NULL;
+}
+
+void SpriteBatch::Write(GLuint index, const AABB &bounds, glm::vec2 uvMin, glm::vec2 uvMax) {
+	if (pulled) {
+		SpriteInstance *sprite = (SpriteInstance*)writer + index;
+		*sprite = SpriteInstance(
+			glm::vec2(0.5f * (bounds.min.x + bounds.max.x), bounds.min.y),
+			bounds.max - bounds.min,
+			uvMin,
+			uvMax,
+			0.0f
+		);
+
+		return;
+	}
+
+	glm::vec2 min = glm::max(bounds.min, this -> bounds.min);
+	glm::vec2 max = glm::min(bounds.max, this -> bounds.max);
+	glm::vec4 white(1.0f, 1.0f, 1.0f, 1.0f);
+
+	/** 
+	 * Same order as the scene quads:
+	 * 	Top right
+	 * 	Bottom right
+	 * 	Bottom left
+	 * 	Top left
+	**/
+	SpriteVertex *quad = (SpriteVertex*)writer + index * 4;
+	quad[0] = SpriteVertex(glm::vec2(max.x, max.y), this -> bounds, glm::vec2(uvMax.x, uvMax.y), white);
+	quad[1] = SpriteVertex(glm::vec2(max.x, min.y), this -> bounds, glm::vec2(uvMax.x, uvMin.y), white);
+	quad[2] = SpriteVertex(glm::vec2(min.x, min.y), this -> bounds, glm::vec2(uvMin.x, uvMin.y), white);
+	quad[3] = SpriteVertex(glm::vec2(min.x, max.y), this -> bounds, glm::vec2(uvMin.x, uvMax.y), white);
+}
+
+void SpriteBatch::Flush() {
+	if (!writer)
+		return;
+
+	GLsizeiptr written = pending * SpriteBytes();
+	stream.Unmap(written);
+	frameBytes += written;
+	writer = NULL;
+
+	if (pending == 0)
+		return;
+
+	GLState::BindVertexArray(VAO);
+
+	// Quads are drawn from where this flush's data starts in the stream
+	if (pulled) {
+		GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, PULLED_BINDING, stream.Buffer());
+		glDrawArrays(GL_TRIANGLES, offset / SpriteBytes() * 6, pending * 6);
+	} else {
+		glDrawElementsBaseVertex(GL_TRIANGLES, pending * 6, GL_UNSIGNED_INT, 0, offset / STRIDE);
+	}
+
+	pending = 0;
+}
+
+void SpriteBatch::End() {
+	Flush();
+	stream.EndFrame();
+}
+
+const AABB &SpriteBatch::Bounds() {
+	return bounds;
+}
+
+GLsizeiptr SpriteBatch::VertexBytes() {
+	return frameBytes;
+}
+
+GLsizeiptr SpriteBatch::VertexBytesSaved() {
+	return frameBytes / SpriteBytes() * (4 * FLOAT_STRIDE - SpriteBytes());
+}
+
+unsigned int SpriteBatch::StreamWaits() {
+	return stream.Waits();
+}
+
+GLsizeiptr SpriteBatch::SpriteBytes() {
+	return pulled ? sizeof(SpriteInstance) : 4 * STRIDE;
+}
@@ -0,0 +1,154 @@
+#include <Classes/SpriteMesh.h>
+#include <algorithm>
+#include <cmath>
+
+// Interpolates count floats at offset across a quad of 4 vertices of 8 floats, with point in [0, 1]
+static glm::vec3 Interpolate(const float *quad, glm::vec2 point, int offset, int count) {
+	// Top right, bottom right, bottom left, top left
+	glm::vec3 corners[4];
+
+	for (int i = 0; i < 4; i++) {
+		corners[i] = glm::vec3(0.0f);
+
+		for (int j = 0; j < count; j++)
+			corners[i][j] = quad[i * 8 + offset + j];
+	}
+
+	// Written as a + (b - a) * t, so points on a shared edge get exactly the same coordinate
+	glm::vec3 bottom = corners[2] + (corners[1] - corners[2]) * point.x;
+	glm::vec3 top = corners[3] + (corners[0] - corners[3]) * point.x;
+
+	return bottom + (top - bottom) * point.y;
+}
+
+SpriteMesh::SpriteMesh() {
+	rectangles.push_back(AABB(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f)));
+}
+
+void SpriteMesh::Trim(const unsigned char *pixels, int width, int height, int channels, int columns, int rows, int cells) {
+	rectangles.clear();
+
+	if (!pixels || channels != 4 || cells <= 0 || columns <= 0 || rows <= 0) {
+		rectangles.push_back(AABB(glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f)));
+		return;
+	}
+
+	// Cells of the frame grid, top row first, as in the image
+	vector<bool> kept(cells * cells, false);
+	GLfloat frameWidth = (GLfloat)width / columns, frameHeight = (GLfloat)height / rows;
+
+	for (int frameY = 0; frameY < rows; frameY++)
+		for (int frameX = 0; frameX < columns; frameX++)
+			for (int cellY = 0; cellY < cells; cellY++)
+				for (int cellX = 0; cellX < cells; cellX++) {
+					if (kept[cellY * cells + cellX])
+						continue;
+
+					// Grown by a pixel, which linear filtering can still bleed into the cell
+					int x0 = std::max((int)floor(frameX * frameWidth + cellX * frameWidth / cells) - 1, 0);
+					int x1 = std::min((int)ceil(frameX * frameWidth + (cellX + 1) * frameWidth / cells) + 1, width);
+					int y0 = std::max((int)floor(frameY * frameHeight + cellY * frameHeight / cells) - 1, 0);
+					int y1 = std::min((int)ceil(frameY * frameHeight + (cellY + 1) * frameHeight / cells) + 1, height);
+
+					bool visible = false;
+
+					for (int y = y0; y < y1 && !visible; y++)
+						for (int x = x0; x < x1 && !visible; x++)
+							visible = pixels[((size_t)y * width + x) * 4 + 3] != 0;
+
+					kept[cellY * cells + cellX] = visible;
+				}
+
+	// Runs of kept cells, extended downwards while the next row has the same run
+	struct Run {
+		int start, end, firstRow;
+	};
+
+	vector<Run> open, next;
+
+	auto close = [this, cells](const Run &run, int endRow) {
+		rectangles.push_back(AABB(
+			glm::vec2((GLfloat)run.start / cells, 1.0f - (GLfloat)endRow / cells),
+			glm::vec2((GLfloat)run.end / cells, 1.0f - (GLfloat)run.firstRow / cells)
+		));
+	};
+
+	for (int cellY = 0; cellY <= cells; cellY++) {
+		next.clear();
+
+		for (int cellX = 0; cellY < cells && cellX < cells; cellX++) {
+			if (!kept[cellY * cells + cellX])
+				continue;
+
+			Run run;
+			run.start = cellX;
+
+			while (cellX < cells && kept[cellY * cells + cellX])
+				cellX++;
+
+			run.end = cellX;
+			run.firstRow = cellY;
+
+			for (const Run &previous : open)
+				if (previous.start == run.start && previous.end == run.end)
+					run.firstRow = previous.firstRow;
+
+			next.push_back(run);
+		}
+
+		for (const Run &previous : open) {
+			bool continued = false;
+
+			for (const Run &run : next)
+				continued = continued || (run.start == previous.start && run.end == previous.end);
+
+			if (!continued)
+				close(previous, cellY);
+		}
+
+		open.swap(next);
+	}
+}
+
+void SpriteMesh::Build(const float *quad, const AABB &bounds, vector<SpriteVertex> &vertices, vector<GLuint> &indices) {
+	vertices.clear();
+	indices.clear();
+
+	for (const AABB &rectangle : rectangles) {
+		GLuint first = vertices.size();
+
+		// Same corner order and triangles as the Setup* quads
+		glm::vec2 corners[4] = {
+			rectangle.max,
+			glm::vec2(rectangle.max.x, rectangle.min.y),
+			rectangle.min,
+			glm::vec2(rectangle.min.x, rectangle.max.y)
+		};
+
+		for (int i = 0; i < 4; i++) {
+			glm::vec3 position = Interpolate(quad, corners[i], 0, 2);
+			glm::vec3 color = Interpolate(quad, corners[i], 3, 3);
+			glm::vec3 texCoord = Interpolate(quad, corners[i], 6, 2);
+
+			vertices.push_back(SpriteVertex(glm::vec2(position.x, position.y), bounds, glm::vec2(texCoord.x, texCoord.y), glm::vec4(color, 1.0f)));
+		}
+
+		GLuint quadIndices[] = {0, 1, 3, 1, 2, 3};
+
+		for (GLuint index : quadIndices)
+			indices.push_back(first + index);
+	}
+}
+
+GLfloat SpriteMesh::Coverage() {
+	GLfloat area = 0.0f;
+
+	for (const AABB &rectangle : rectangles)
+		area += (rectangle.max.x - rectangle.min.x) * (rectangle.max.y - rectangle.min.y);
+
+	return area;
+}
+
+unsigned int SpriteMesh::RectangleCount() {
+	return rectangles.size();
+}
@@ -0,0 +1,107 @@
+#include <Classes/StreamBuffer.h>
+#include <Classes/GLExtensions.h>
+#include <Classes/GLState.h>
+#include <cstddef>
+
+StreamBuffer::StreamBuffer() {
+	buffer = 0;
+	regionSize = 0;
+	used = 0;
+	region = 0;
+	persistent = false;
+	mapped = false;
+	memory = NULL;
+	waits = 0;
+
+	for (int i = 0; i < REGIONS; i++)
+		fences[i] = 0;
+}
+
+void StreamBuffer::Create(GLenum target, GLsizeiptr regionSize) {
+	this -> target = target;
+	this -> regionSize = regionSize;
+
+	glGenBuffers(1, &buffer);
+	GLState::BindBuffer(target, buffer);
+
+	persistent = GLExtensions::bufferStorage;
+
+	if (persistent) {
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(target, regionSize * REGIONS, NULL, flags);
+		memory = (unsigned char*)glMapBufferRange(target, 0, regionSize * REGIONS, flags);
+	} else {
+		glBufferData(target, regionSize * REGIONS, NULL, GL_STREAM_DRAW);
+	}
+
+	// Starts right before the first region
+	region = REGIONS - 1;
+	used = regionSize;
+}
+
+void StreamBuffer::BeginFrame() {
+	region = (region + 1) % REGIONS;
+	used = 0;
+
+	GLsync &fence = fences[region];
+	if (!fence)
+		return;
+
+	GLenum status = glClientWaitSync(fence, 0, 0);
+
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+		waits++;
+
+		do {
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	fence = 0;
+}
+
+void* StreamBuffer::Map(GLsizeiptr maxBytes, GLsizeiptr alignment, GLintptr &offset, GLsizeiptr &available) {
+	used = (used + alignment - 1) / alignment * alignment;
+	available = regionSize - used;
+
+	if (available <= 0)
+		return NULL;
+	if (available > maxBytes)
+		available = maxBytes;
+
+	offset = region * regionSize + used;
+
+	if (persistent)
+		return memory + offset;
+
+	GLState::BindBuffer(target, buffer);
+	mapped = true;
+	return glMapBufferRange(target, offset, available, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+}
+
+void StreamBuffer::Unmap(GLsizeiptr written) {
+	used += written;
+
+	if (!mapped)
+		return;
+
+	GLState::BindBuffer(target, buffer);
+	glUnmapBuffer(target);
+	mapped = false;
+}
+
+void StreamBuffer::EndFrame() {
+	if (fences[region])
+		glDeleteSync(fences[region]);
+
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+GLuint StreamBuffer::Buffer() {
+	return buffer;
+}
+
+unsigned int StreamBuffer::Waits() {
+	return waits;
+}
@@ -0,0 +1,333 @@
+#include <Classes/Tilemap.h>
+#include <Classes/STB_Image.h>
+#include <Classes/GLState.h>
+#include <Classes/ImageAlpha.h>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cmath>
+
+Tilemap::Tilemap() {
+	tileset = 0;
+	tilesetOpaque = false;
+	indexBuffer = 0;
+	columns = 1;
+	rows = 1;
+	tileSize = 0.125f;
+	origin = glm::vec2(0.0f, 0.0f);
+	rebuilds = 0;
+}
+
+bool Tilemap::Load(string filename) {
+	std::ifstream file(filename.c_str());
+
+	if (!file) {
+		std::cout << "Failed to load tilemap " << filename << std::endl;
+		return false;
+	}
+
+	string header, textureFile;
+	std::getline(file, header);
+
+	std::stringstream headerStream(header);
+	headerStream >> textureFile >> columns >> rows >> tileSize >> origin.x >> origin.y;
+
+	LoadTileset(textureFile, columns, rows);
+
+	vector<string> lines;
+	string line;
+
+	while (std::getline(file, line))
+		if (!line.empty())
+			lines.push_back(line);
+
+	// First line is the top row
+	for (int row = 0; row < (int)lines.size(); row++) {
+		int y = lines.size() - 1 - row;
+
+		for (int x = 0; x < (int)lines[row].size(); x++)
+			SetTile(x, y, TileIndex(lines[row][x]));
+	}
+
+	return true;
+}
+
+void Tilemap::Clear() {
+	while (!chunks.empty()) {
+		Chunk &chunk = chunks.begin() -> second;
+
+		if (chunk.VAO) {
+			GLState::DeleteVertexArrays(1, &chunk.VAO);
+			GLState::DeleteBuffers(1, &chunk.VBO);
+		}
+
+		chunks.erase(chunks.begin());
+	}
+}
+
+void Tilemap::SetTileset(GLuint texture, int columns, int rows, bool opaque) {
+	tileset = texture;
+	tilesetOpaque = opaque;
+	this -> columns = columns;
+	this -> rows = rows;
+
+	for (auto &chunk : chunks)
+		chunk.second.dirty = true;
+}
+
+void Tilemap::LoadTileset(string filename, int columns, int rows) {
+	bool opaque;
+	GLuint texture = LoadTexture(filename, opaque);
+
+	SetTileset(texture, columns, rows, opaque);
+}
+
+bool Tilemap::TilesetOpaque() {
+	return tilesetOpaque;
+}
+
+void Tilemap::SetTileSize(GLfloat tileSize) {
+	this -> tileSize = tileSize;
+
+	for (auto &chunk : chunks)
+		chunk.second.dirty = true;
+}
+
+void Tilemap::SetOrigin(glm::vec2 origin) {
+	this -> origin = origin;
+
+	for (auto &chunk : chunks)
+		chunk.second.dirty = true;
+}
+
+void Tilemap::SetTile(int x, int y, int tile) {
+	int chunkX = (int)std::floor(x / (float)CHUNK_SIZE);
+	int chunkY = (int)std::floor(y / (float)CHUNK_SIZE);
+
+	auto found = chunks.find(ChunkKey(chunkX, chunkY));
+
+	if (found == chunks.end()) {
+		if (tile < 0)
+			return;
+
+		Chunk chunk;
+		chunk.tiles.assign(CHUNK_SIZE * CHUNK_SIZE, -1);
+		chunk.VAO = 0;
+		chunk.VBO = 0;
+		chunk.indexCount = 0;
+		chunk.dirty = false;
+		found = chunks.insert(std::make_pair(ChunkKey(chunkX, chunkY), chunk)).first;
+	}
+
+	Chunk &chunk = found -> second;
+	short &current = chunk.tiles[(y - chunkY * CHUNK_SIZE) * CHUNK_SIZE + (x - chunkX * CHUNK_SIZE)];
+
+	if (current != tile) {
+		current = tile;
+		chunk.dirty = true;
+	}
+}
+
+int Tilemap::GetTile(int x, int y) {
+	int chunkX = (int)std::floor(x / (float)CHUNK_SIZE);
+	int chunkY = (int)std::floor(y / (float)CHUNK_SIZE);
+
+	auto found = chunks.find(ChunkKey(chunkX, chunkY));
+	if (found == chunks.end())
+		return -1;
+
+	return found -> second.tiles[(y - chunkY * CHUNK_SIZE) * CHUNK_SIZE + (x - chunkX * CHUNK_SIZE)];
+}
+
+void Tilemap::RemoveChunk(int chunkX, int chunkY) {
+	auto found = chunks.find(ChunkKey(chunkX, chunkY));
+	if (found == chunks.end())
+		return;
+
+	if (found -> second.VAO) {
+		GLState::DeleteVertexArrays(1, &found -> second.VAO);
+		GLState::DeleteBuffers(1, &found -> second.VBO);
+	}
+
+	chunks.erase(found);
+}
+
+unsigned int Tilemap::Draw(const AABB &view) {
+	if (chunks.empty())
+		return 0;
+
+	if (!indexBuffer)
+		SetupIndices();
+
+	GLfloat chunkExtent = CHUNK_SIZE * tileSize;
+
+	int xMin = (int)std::floor((view.min.x - origin.x) / chunkExtent);
+	int yMin = (int)std::floor((view.min.y - origin.y) / chunkExtent);
+	int xMax = (int)std::floor((view.max.x - origin.x) / chunkExtent);
+	int yMax = (int)std::floor((view.max.y - origin.y) / chunkExtent);
+
+	unsigned int drawn = 0;
+
+	GLState::BindTexture(GL_TEXTURE_2D, tileset);
+
+	for (int chunkY = yMin; chunkY <= yMax; chunkY++)
+		for (int chunkX = xMin; chunkX <= xMax; chunkX++) {
+			auto found = chunks.find(ChunkKey(chunkX, chunkY));
+			if (found == chunks.end())
+				continue;
+
+			Chunk &chunk = found -> second;
+
+			// Edited chunks are only rebuilt when they are about to be drawn
+			if (chunk.dirty)
+				BuildChunk(chunkX, chunkY, chunk);
+
+			if (chunk.indexCount == 0)
+				continue;
+
+			GLState::BindVertexArray(chunk.VAO);
+			glDrawElements(GL_TRIANGLES, chunk.indexCount, GL_UNSIGNED_INT, 0);
+			drawn++;
+		}
+
+	return drawn;
+}
+
+unsigned int Tilemap::ChunkCount() {
+	return chunks.size();
+}
+
+unsigned int Tilemap::Rebuilds() {
+	return rebuilds;
+}
+
+int Tilemap::TileIndex(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'z')
+		return 10 + c - 'a';
+
+	return -1;
+}
+
+long long Tilemap::ChunkKey(int chunkX, int chunkY) {
+	return ((long long)chunkX << 32) | (unsigned int)chunkY;
+}
+
+void Tilemap::BuildChunk(int chunkX, int chunkY, Chunk &chunk) {
+	/** 
+	 * 5-float vertices: position (3) and texture coordinates (2),
+	 * 4 per tile, in the same order as the scene quads:
+	 * 	Top right
+	 * 	Bottom right
+	 * 	Bottom left
+	 * 	Top left
+	**/
+	vector<float> vertices;
+	vertices.reserve(CHUNK_SIZE * CHUNK_SIZE * 4 * 5);
+
+	float tileWidth = 1.0f / columns, tileHeight = 1.0f / rows;
+
+	for (int y = 0; y < CHUNK_SIZE; y++)
+		for (int x = 0; x < CHUNK_SIZE; x++) {
+			int tile = chunk.tiles[y * CHUNK_SIZE + x];
+			if (tile < 0)
+				continue;
+
+			float left = origin.x + (chunkX * CHUNK_SIZE + x) * tileSize, right = left + tileSize;
+			float bottom = origin.y + (chunkY * CHUNK_SIZE + y) * tileSize, top = bottom + tileSize;
+
+			// Row 0 is the top of the tileset image, which Shader.vs flips
+			float u0 = (tile % columns) * tileWidth, u1 = u0 + tileWidth;
+			float v1 = 1.0f - (tile / columns) * tileHeight, v0 = v1 - tileHeight;
+
+			float quad[] = {
+				right,	top,	0.0f,	u1, v1,
+				right,	bottom,	0.0f,	u1, v0,
+				left,	bottom,	0.0f,	u0, v0,
+				left,	top,	0.0f,	u0, v1
+			};
+
+			vertices.insert(vertices.end(), quad, quad + 20);
+		}
+
+	chunk.indexCount = vertices.size() / 20 * 6;
+	chunk.dirty = false;
+	rebuilds++;
+
+	if (chunk.indexCount == 0)
+		return;
+
+	if (!chunk.VAO) {
+		glGenVertexArrays(1, &chunk.VAO);
+		glGenBuffers(1, &chunk.VBO);
+
+		GLState::BindVertexArray(chunk.VAO);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+		GLState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+		// Position
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+		glEnableVertexAttribArray(0);
+
+		// Texture coords
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+		glEnableVertexAttribArray(2);
+	} else {
+		GLState::BindVertexArray(chunk.VAO);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, chunk.VBO);
+	}
+
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+}
+
+void Tilemap::SetupIndices() {
+	// Shared by every chunk: two triangles per tile, for a full chunk
+	vector<GLuint> indices;
+	indices.reserve(CHUNK_SIZE * CHUNK_SIZE * 6);
+
+	for (GLuint tile = 0; tile < CHUNK_SIZE * CHUNK_SIZE; tile++) {
+		GLuint first = tile * 4;
+		GLuint quad[] = {
+			first + 0, first + 1, first + 3,
+			first + 1, first + 2, first + 3
+		};
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+
+	// Uploaded through the array buffer target, as binding an element buffer would change the current VAO
+	glGenBuffers(1, &indexBuffer);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+}
+
+GLuint Tilemap::LoadTexture(string filename, bool &opaque) {
+	GLuint texture;
+
+	glGenTextures(1, &texture);
+	GLState::BindTexture(GL_TEXTURE_2D, texture);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Loads image, creates texture and generates mipmaps
+	int tilesetWidth, tilesetHeight, tilesetNrChannels;
+	unsigned char *tilesetData = stbi_load(filename.c_str(), &tilesetWidth, &tilesetHeight, &tilesetNrChannels, 0);
+	opaque = ImageAlpha::Opaque(tilesetData, tilesetWidth, tilesetHeight, tilesetNrChannels);
+
+	if (tilesetData) {
+		GLenum format = tilesetNrChannels == 4 ? GL_RGBA : GL_RGB;
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tilesetWidth, tilesetHeight, 0, format, GL_UNSIGNED_BYTE, tilesetData);
+		glGenerateMipmap(GL_TEXTURE_2D);
+	} else {
+		std::cout << "Failed to load tileset texture" << std::endl;
+	}
+	stbi_image_free(tilesetData);
+
+	GLState::BindTexture(GL_TEXTURE_2D, 0);
+
+	return texture;
+}